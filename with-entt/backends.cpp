@@ -0,0 +1,14 @@
+#include <entt/entt.hpp>
+
+#include "backends.hpp"
+#include "bitgrid.hpp"
+#include "hashlife.hpp"
+
+bool has_alive_cells(entt::registry &registry) {
+    auto view = registry.view<entt::tag<"is_alive"_hs>>();
+    return view.size() > 0;
+}
+
+bool has_alive_cells(const BitGrid &grid) { return grid.population() > 0; }
+
+bool has_alive_cells(const Hashlife &life) { return life.population() > 0; }
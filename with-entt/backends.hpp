@@ -0,0 +1,10 @@
+#pragma once
+
+#include <entt/entt.hpp>
+
+#include "bitgrid.hpp"
+#include "hashlife.hpp"
+
+bool has_alive_cells(entt::registry &registry);
+bool has_alive_cells(const BitGrid &grid);
+bool has_alive_cells(const Hashlife &life);
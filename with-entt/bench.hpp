@@ -0,0 +1,42 @@
+#pragma once
+
+#include <random>
+
+#include <benchmark/benchmark.h>
+#include <entt/entt.hpp>
+
+#include "components.hpp"
+
+/**
+ * The matrix of board sizes and live cell percentages the registry systems
+ * and checks are run over, from boards that have died out to crowded ones.
+ * Every board is seeded the same way each run, so results can be compared
+ * between commits.
+ */
+inline void size_density_matrix(benchmark::internal::Benchmark *bench) {
+    for (auto dim : {64, 256, 1024}) {
+        for (auto density : {0, 5, 30, 60}) {
+            bench->Args({dim, density});
+        }
+    }
+    bench->ArgNames({"dim", "density"});
+    bench->Unit(benchmark::kMicrosecond);
+}
+
+/**
+ * Fill a dim x dim registry where each cell is alive with the given
+ * probability.
+ */
+inline void seed_board(entt::registry &registry, int dim, double density) {
+    std::mt19937 rand_gen(42);
+    std::bernoulli_distribution alive(density);
+    for (auto x = 0; x < dim; x++) {
+        for (auto y = 0; y < dim; y++) {
+            auto entity = registry.create();
+            registry.assign<Position>(entity, x, y);
+            if (alive(rand_gen)) {
+                registry.assign<entt::tag<"is_alive"_hs>>(entity);
+            }
+        }
+    }
+}
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "bitgrid.hpp"
+#include "life_kernel.hpp"
+#include "topology.hpp"
+
+BitGrid::BitGrid(int width_, int height_)
+    : w(width_), h(height_), row_words((width_ + word_bits - 1) / word_bits),
+      stride(row_words + 2),
+      last_word_mask(width_ % word_bits == 0
+                         ? ~Word(0)
+                         : (Word(1) << (width_ % word_bits)) - 1),
+      cells(stride * (height_ + 2), 0), next(stride * (height_ + 2), 0),
+      kernel_isa(best_kernel_isa()), step_rule(conway_rule),
+      edges(Topology::dead), kernel(row_kernel(kernel_isa, step_rule)),
+      generations(0), swapped(false) {}
+
+bool BitGrid::get(int x, int y) const {
+    auto word = cells[row_offset(y) + x / word_bits];
+    return (word >> (x % word_bits)) & 1;
+}
+
+void BitGrid::set(int x, int y, bool alive) {
+    auto &word = cells[row_offset(y) + x / word_bits];
+    auto bit = Word(1) << (x % word_bits);
+    word = alive ? word | bit : word & ~bit;
+    swapped = false;
+}
+
+std::size_t BitGrid::population() const {
+    std::size_t count = 0;
+    for (auto word : cells) {
+        count += std::bitset<word_bits>(word).count();
+    }
+    return count;
+}
+
+void BitGrid::use_kernel(KernelIsa isa) {
+    kernel_isa = isa;
+    kernel = row_kernel(kernel_isa, step_rule);
+}
+
+void BitGrid::set_rule(Rule rule_) {
+    step_rule = rule_;
+    kernel = row_kernel(kernel_isa, step_rule);
+}
+
+void BitGrid::step() {
+    swapped = false;
+    if (edges != Topology::dead) {
+        fill_border();
+    }
+    for (auto y = 0; y < h; y++) {
+        auto out = &next[row_offset(y)];
+        kernel(&cells[row_offset(y - 1)], &cells[row_offset(y)],
+               &cells[row_offset(y + 1)], out, row_words, step_rule);
+        out[row_words - 1] &= last_word_mask;
+    }
+    if (edges != Topology::dead) {
+        clear_border();
+    }
+}
+
+/**
+ * Copy the cells on each edge of the board into the border beyond the
+ * opposite edge, so the kernel reads them as neighbours. Costs a few words
+ * a row, against the whole row the kernel steps.
+ */
+void BitGrid::fill_border() {
+    for (auto y = 0; y < h; y++) {
+        fill_row_ends(&cells[row_offset(y)]);
+    }
+    // The rows above and below take their ends from the rows they copy
+    if (edges == Topology::klein_bottle) {
+        mirror_row(&cells[row_offset(h - 1)], &cells[row_offset(-1)]);
+        mirror_row(&cells[row_offset(0)], &cells[row_offset(h)]);
+        fill_row_ends(&cells[row_offset(-1)]);
+        fill_row_ends(&cells[row_offset(h)]);
+    } else {
+        std::copy_n(&cells[row_offset(h - 1) - 1], stride,
+                    &cells[row_offset(-1) - 1]);
+        std::copy_n(&cells[row_offset(0) - 1], stride,
+                    &cells[row_offset(h) - 1]);
+    }
+}
+
+/**
+ * Put the last cell of a row before it and the first cell after it. The
+ * cell after the row is in the last word unless the row fills it.
+ */
+void BitGrid::fill_row_ends(Word *row) {
+    auto last = w - 1;
+    row[-1] = ((row[last / word_bits] >> (last % word_bits)) & 1)
+              << (word_bits - 1);
+    auto first = row[0] & 1;
+    if (w % word_bits == 0) {
+        row[row_words] = first;
+    } else {
+        row[row_words - 1] |= first << (w % word_bits);
+    }
+}
+
+/**
+ * Write a row into another flipped left to right.
+ */
+void BitGrid::mirror_row(const Word *from, Word *to) {
+    std::fill_n(to, row_words, Word(0));
+    for (auto i = 0; i < row_words; i++) {
+        auto word = i == row_words - 1 ? from[i] & last_word_mask : from[i];
+        while (word != 0) {
+            auto x = w - 1 - (i * word_bits + lowest_bit(word));
+            to[x / word_bits] |= Word(1) << (x % word_bits);
+            word &= word - 1;
+        }
+    }
+}
+
+/**
+ * Kill the border again, so only the board's own cells are ever alive
+ * between steps.
+ */
+void BitGrid::clear_border() {
+    for (auto y = 0; y < h; y++) {
+        auto row = &cells[row_offset(y)];
+        row[-1] = 0;
+        row[row_words - 1] &= last_word_mask;
+        row[row_words] = 0;
+    }
+    std::fill_n(&cells[row_offset(-1) - 1], stride, Word(0));
+    std::fill_n(&cells[row_offset(h) - 1], stride, Word(0));
+}
+
+void BitGrid::swap() {
+    cells.swap(next);
+    generations++;
+    swapped = true;
+}
+
+int BitGrid::lowest_bit(Word word) {
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanForward64(&bit, word);
+    return static_cast<int>(bit);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+std::size_t BitGrid::row_offset(int y) const { return (y + 1) * stride + 1; }
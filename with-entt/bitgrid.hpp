@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "components.hpp"
+#include "life_kernel.hpp"
+#include "rule.hpp"
+#include "topology.hpp"
+
+/**
+ * A dense, bit-packed and double-buffered Game of Life board.
+ *
+ * Each cell is one bit, 64 cells to a word, with a one word border of dead
+ * cells around every row and the board so the next generation can be
+ * computed a word at a time without bounds checks, using the fastest row
+ * kernel the CPU supports. Cells outside of the board are dead, matching the
+ * registry where no entity exists outside of the arena, unless the board
+ * wraps. Then the border is filled from the opposite edges for the length of
+ * each step, so a wrapped board steps with the same kernel.
+ */
+class BitGrid {
+  public:
+    typedef std::uint64_t Word;
+    static const int word_bits = 64;
+
+    BitGrid(int width_, int height_);
+
+    int width() const { return w; }
+    int height() const { return h; }
+
+    bool get(int x, int y) const;
+    void set(int x, int y, bool alive);
+
+    /**
+     * Number of live cells on the current board.
+     */
+    std::size_t population() const;
+
+    /**
+     * Compute the next generation into the back buffer.
+     */
+    void step();
+
+    /**
+     * Step rows with the kernel for the given instruction set instead.
+     */
+    void use_kernel(KernelIsa isa);
+
+    /**
+     * Step with the given rule rather than B3/S23.
+     */
+    void set_rule(Rule rule_);
+    Rule rule() const { return step_rule; }
+
+    void set_topology(Topology topology_) { edges = topology_; }
+    Topology topology() const { return edges; }
+
+    /**
+     * Make the back buffer the current board.
+     */
+    void swap();
+
+    /**
+     * Number of times the back buffer has been made the current board.
+     */
+    std::int64_t generation() const { return generations; }
+
+    /**
+     * Call f with the Position of every cell that changed in the last swap
+     * and whether it is now alive. The changes are only known until the next
+     * step or set, returns false without calling f after those.
+     */
+    template <typename F> bool each_change(F f) const {
+        if (!swapped) {
+            return false;
+        }
+        for (auto y = 0; y < h; y++) {
+            auto row = &cells[row_offset(y)];
+            auto previous = &next[row_offset(y)];
+            for (auto i = 0; i < row_words; i++) {
+                auto word = row[i] ^ previous[i];
+                while (word != 0) {
+                    auto bit = lowest_bit(word);
+                    f(Position(i * word_bits + bit, y), (row[i] >> bit) & 1);
+                    word &= word - 1;
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Call f with the Position of every live cell on the current board.
+     */
+    template <typename F> void each_alive(F f) const {
+        for (auto y = 0; y < h; y++) {
+            auto row = &cells[row_offset(y)];
+            for (auto i = 0; i < row_words; i++) {
+                auto word = row[i];
+                while (word != 0) {
+                    auto bit = lowest_bit(word);
+                    f(Position(i * word_bits + bit, y));
+                    word &= word - 1;
+                }
+            }
+        }
+    }
+
+  private:
+    static int lowest_bit(Word word);
+    std::size_t row_offset(int y) const;
+    void fill_border();
+    void fill_row_ends(Word *row);
+    void mirror_row(const Word *from, Word *to);
+    void clear_border();
+
+    int w;
+    int h;
+    int row_words;
+    std::size_t stride;
+    Word last_word_mask;
+    std::vector<Word> cells;
+    std::vector<Word> next;
+    KernelIsa kernel_isa;
+    Rule step_rule;
+    Topology edges;
+    RowKernel kernel;
+    std::int64_t generations;
+    // Whether next still holds the board from before the last swap
+    bool swapped;
+};
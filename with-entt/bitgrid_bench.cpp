@@ -0,0 +1,103 @@
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+#include "bitgrid.hpp"
+#include "life_kernel.hpp"
+#include "rule.hpp"
+#include "topology.hpp"
+
+// Generations per second of the bit grid with each row kernel the CPU
+// supports.
+static void BM_bitgrid_step(benchmark::State &state) {
+    auto dim = static_cast<int>(state.range(0));
+    auto isa = static_cast<KernelIsa>(state.range(1));
+    state.SetLabel(kernel_isa_name(isa));
+
+    BitGrid grid(dim, dim);
+    grid.use_kernel(isa);
+    std::mt19937 rand_gen(42);
+    std::bernoulli_distribution alive(0.3);
+    for (auto x = 0; x < dim; x++) {
+        for (auto y = 0; y < dim; y++) {
+            grid.set(x, y, alive(rand_gen));
+        }
+    }
+
+    for (auto _ : state) {
+        grid.step();
+        grid.swap();
+    }
+    state.SetItemsProcessed(state.iterations() * dim * dim);
+}
+BENCHMARK(BM_bitgrid_step)
+    ->Apply([](benchmark::internal::Benchmark *bench) {
+        for (auto isa : available_kernel_isas()) {
+            for (auto dim : {256, 1024, 4096}) {
+                bench->Args({dim, static_cast<int64_t>(isa)});
+            }
+        }
+    })
+    ->Unit(benchmark::kMicrosecond);
+
+// Generations per second with each rule, the common ones have kernels of
+// their own while the last is looked up from its mask.
+static void BM_bitgrid_rule(benchmark::State &state) {
+    const Rule rules[] = {conway_rule, highlife_rule, day_and_night_rule,
+                          Rule(neighbour_counts({3, 6}),
+                               neighbour_counts({1, 2, 5}))};
+    auto rule = rules[state.range(0)];
+    state.SetLabel(rule_name(rule));
+
+    const int dim = 1024;
+    BitGrid grid(dim, dim);
+    grid.set_rule(rule);
+    std::mt19937 rand_gen(42);
+    std::bernoulli_distribution alive(0.3);
+    for (auto x = 0; x < dim; x++) {
+        for (auto y = 0; y < dim; y++) {
+            grid.set(x, y, alive(rand_gen));
+        }
+    }
+
+    for (auto _ : state) {
+        grid.step();
+        grid.swap();
+    }
+    state.SetItemsProcessed(state.iterations() * dim * dim);
+}
+BENCHMARK(BM_bitgrid_rule)->DenseRange(0, 3)->Unit(benchmark::kMicrosecond);
+
+// Generations per second with each topology, filling the border each step
+// should cost next to nothing against stepping the board.
+static void BM_bitgrid_topology(benchmark::State &state) {
+    auto dim = static_cast<int>(state.range(0));
+    auto topology = static_cast<Topology>(state.range(1));
+    state.SetLabel(topology_name(topology));
+
+    BitGrid grid(dim, dim);
+    grid.set_topology(topology);
+    std::mt19937 rand_gen(42);
+    std::bernoulli_distribution alive(0.3);
+    for (auto x = 0; x < dim; x++) {
+        for (auto y = 0; y < dim; y++) {
+            grid.set(x, y, alive(rand_gen));
+        }
+    }
+
+    for (auto _ : state) {
+        grid.step();
+        grid.swap();
+    }
+    state.SetItemsProcessed(state.iterations() * dim * dim);
+}
+BENCHMARK(BM_bitgrid_topology)
+    ->Apply([](benchmark::internal::Benchmark *bench) {
+        for (auto topology :
+             {Topology::dead, Topology::torus, Topology::klein_bottle}) {
+            for (auto dim : {256, 1024}) {
+                bench->Args({dim, static_cast<int64_t>(topology)});
+            }
+        }
+    })
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,182 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <random>
+#include <set>
+
+#include <doctest.h>
+#include <entt/entt.hpp>
+
+#include "backends.hpp"
+#include "bitgrid.hpp"
+#include "components.hpp"
+#include "systems.hpp"
+#include "topology.hpp"
+
+std::set<Position> alive_positions(const BitGrid &grid) {
+    std::set<Position> alive;
+    grid.each_alive([&](Position pos) { alive.insert(pos); });
+    return alive;
+}
+
+std::set<Position> alive_positions(entt::registry &registry) {
+    std::set<Position> alive;
+    registry.view<Position, entt::tag<"is_alive"_hs>>().each(
+        [&](auto &pos, auto _) { alive.insert(pos); });
+    return alive;
+}
+
+void generation(BitGrid &grid) {
+    lifecycle_system(grid);
+    cleanup_system(grid);
+    update_system(grid);
+}
+
+void generation(entt::registry &registry) {
+    lifecycle_system(registry);
+    cleanup_system(registry);
+    update_system(registry);
+}
+
+TEST_SUITE("BitGrid") {
+    TEST_CASE("cells can be set and cleared") {
+        BitGrid grid(100, 3);
+
+        grid.set(0, 0, true);
+        grid.set(63, 1, true);
+        grid.set(64, 1, true);
+        grid.set(99, 2, true);
+
+        REQUIRE(grid.get(0, 0));
+        REQUIRE(grid.get(63, 1));
+        REQUIRE(grid.get(64, 1));
+        REQUIRE(grid.get(99, 2));
+        REQUIRE_FALSE(grid.get(1, 0));
+        REQUIRE(grid.population() == 4);
+
+        grid.set(63, 1, false);
+        REQUIRE_FALSE(grid.get(63, 1));
+        REQUIRE(grid.population() == 3);
+    }
+
+    TEST_CASE("the cells changed by the last swap are reported") {
+        BitGrid grid(128, 5);
+        grid.set(63, 2, true);
+        grid.set(64, 2, true);
+        grid.set(65, 2, true);
+        REQUIRE_FALSE(grid.each_change([](Position, bool) {}));
+
+        generation(grid);
+        REQUIRE(grid.generation() == 1);
+        std::set<Position> born, died;
+        REQUIRE(grid.each_change([&](Position pos, bool alive) {
+            (alive ? born : died).insert(pos);
+        }));
+        REQUIRE(born == std::set<Position>{Position(64, 1), Position(64, 3)});
+        REQUIRE(died == std::set<Position>{Position(63, 2), Position(65, 2)});
+
+        lifecycle_system(grid);
+        REQUIRE_FALSE(grid.each_change([](Position, bool) {}));
+    }
+
+    TEST_CASE("a blinker across a word boundary oscillates") {
+        BitGrid grid(128, 5);
+        grid.set(63, 2, true);
+        grid.set(64, 2, true);
+        grid.set(65, 2, true);
+
+        generation(grid);
+        REQUIRE(alive_positions(grid) ==
+                std::set<Position>{Position(64, 1), Position(64, 2),
+                                   Position(64, 3)});
+
+        generation(grid);
+        REQUIRE(alive_positions(grid) ==
+                std::set<Position>{Position(63, 2), Position(64, 2),
+                                   Position(65, 2)});
+    }
+
+    TEST_CASE("cells beyond the edge of the board are dead") {
+        BitGrid grid(3, 3);
+        grid.set(0, 0, true);
+        grid.set(1, 0, true);
+        grid.set(2, 0, true);
+
+        generation(grid);
+        REQUIRE(alive_positions(grid) ==
+                std::set<Position>{Position(1, 0), Position(1, 1)});
+        REQUIRE(has_alive_cells(grid));
+    }
+
+    TEST_CASE("matches the registry for random boards") {
+        int width = 70, height = 12;
+        std::random_device rand_dev;
+        std::mt19937 rand_gen(rand_dev());
+        std::bernoulli_distribution alive(0.35);
+
+        BitGrid grid(width, height);
+        entt::registry registry;
+        for (auto x = 0; x < width; x++) {
+            for (auto y = 0; y < height; y++) {
+                auto entity = registry.create();
+                registry.assign<Position>(entity, x, y);
+                if (alive(rand_gen)) {
+                    grid.set(x, y, true);
+                    registry.assign<entt::tag<"is_alive"_hs>>(entity);
+                }
+            }
+        }
+
+        for (auto round = 0; round < 10; round++) {
+            CAPTURE(round);
+            REQUIRE(alive_positions(grid) == alive_positions(registry));
+            generation(grid);
+            generation(registry);
+        }
+    }
+
+    TEST_CASE("a glider comes back around a torus") {
+        // Filling whole words, and not
+        auto dim = 64;
+        SUBCASE("64 wide") {}
+        SUBCASE("10 wide") { dim = 10; }
+        CAPTURE(dim);
+
+        BitGrid grid(dim, dim);
+        grid.set_topology(Topology::torus);
+        std::set<Position> glider = {Position(1, 0), Position(2, 1),
+                                     Position(0, 2), Position(1, 2),
+                                     Position(2, 2)};
+        for (auto pos : glider) {
+            grid.set(pos.x, pos.y, true);
+        }
+
+        // A glider moves one cell diagonally every four generations
+        for (auto round = 0; round < 4 * dim; round++) {
+            generation(grid);
+            REQUIRE(grid.population() == 5);
+        }
+        REQUIRE(alive_positions(grid) == glider);
+    }
+
+    TEST_CASE("a blinker across the top of a Klein bottle comes back "
+              "flipped") {
+        BitGrid grid(8, 6);
+        grid.set_topology(Topology::klein_bottle);
+        // The cell above (1, 0) is (8 - 1 - 1, 5)
+        grid.set(6, 5, true);
+        grid.set(1, 0, true);
+        grid.set(1, 1, true);
+
+        generation(grid);
+        REQUIRE(alive_positions(grid) ==
+                std::set<Position>{Position(0, 0), Position(1, 0),
+                                   Position(2, 0)});
+        REQUIRE(grid.population() == 3);
+    }
+
+    TEST_CASE("initialise_grid creates the given number of live cells") {
+        BitGrid grid(10, 10);
+        initialise_grid(grid, 10);
+        REQUIRE(grid.population() == 10);
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+
+#include "components.hpp"
+
+/**
+ * Called with each batch of live cells read from a file.
+ */
+typedef std::function<void(const Position *cells, std::size_t n_cells)>
+    CellBatch;
+
+/**
+ * The cells in [x_begin, x_end) by [y_begin, y_end).
+ */
+struct CellBox {
+    std::int64_t x_begin;
+    std::int64_t y_begin;
+    std::int64_t x_end;
+    std::int64_t y_end;
+
+    /**
+     * Every cell that fits in a Position.
+     */
+    static CellBox positions() {
+        const std::int64_t min = std::numeric_limits<int>::min();
+        const std::int64_t max = std::numeric_limits<int>::max();
+        return CellBox{min, min, max + 1, max + 1};
+    }
+};
+
+/**
+ * Collects cells read from a file, moved to an origin, and hands them over a
+ * fixed size batch at a time. Cells outside of a clipping box, which must
+ * lie within the range of a Position, are dropped.
+ */
+class CellBatcher {
+  public:
+    CellBatcher(std::int64_t x_, std::int64_t y_, const CellBatch &f_,
+                const CellBox &clip_ = CellBox::positions())
+        : origin_x(x_), origin_y(y_), clip(clip_), f(f_), n_cells(0) {}
+
+    /**
+     * Add a run of n live cells going right from x, y.
+     */
+    void add(std::int64_t x, std::int64_t y, std::int64_t n = 1) {
+        // The run is cut to the box before any of its cells are walked, so
+        // a long run far outside of it costs nothing. The box is moved back
+        // to the file's coordinates, which can't overflow where the run's
+        // position would.
+        if (y < clip.y_begin - origin_y || y >= clip.y_end - origin_y) {
+            return;
+        }
+        auto begin = clip.x_begin - origin_x, end = clip.x_end - origin_x;
+        if (x >= end) {
+            return;
+        } else if (x < begin) {
+            if (n <= begin - x) {
+                return;
+            }
+            n -= begin - x;
+            x = begin;
+        }
+        auto last = x + std::min(n, end - x);
+        for (auto cell_x = x; cell_x < last; cell_x++) {
+            cells[n_cells++] =
+                Position(int(cell_x + origin_x), int(y + origin_y));
+            if (n_cells == batch_size) {
+                flush();
+            }
+        }
+    }
+
+    void flush() {
+        if (n_cells > 0) {
+            f(cells, n_cells);
+            n_cells = 0;
+        }
+    }
+
+  private:
+    static const std::size_t batch_size = 4096;
+
+    std::int64_t origin_x;
+    std::int64_t origin_y;
+    CellBox clip;
+    const CellBatch &f;
+    std::size_t n_cells;
+    Position cells[batch_size];
+};
@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "cell_batcher.hpp"
+#include "checkpoint.hpp"
+#include "components.hpp"
+#include "rule.hpp"
+
+static const char checkpoint_magic[8] = {'G', 'O', 'L', 'C', 'K', 'P', 'T', 0};
+static const std::uint32_t checkpoint_version = 2;
+static const int word_bits = 64;
+
+static int lowest_bit(std::uint64_t word) {
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanForward64(&bit, word);
+    return static_cast<int>(bit);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+static void put_varint(std::vector<char> &data, std::uint64_t value) {
+    while (value >= 0x80) {
+        data.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<char>(value));
+}
+
+static bool get_varint(const char *&p, const char *end, std::uint64_t &value) {
+    value = 0;
+    for (auto shift = 0; p < end && shift < 64; shift += 7) {
+        auto byte = static_cast<std::uint8_t>(*p++);
+        value |= std::uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Encode cells sorted into row order as runs through the bounding box at
+ * x, y of the given width.
+ */
+static std::vector<char> encode_runs(const std::vector<Position> &live,
+                                     std::int64_t x, std::int64_t y,
+                                     std::int64_t width) {
+    std::vector<char> data;
+    std::uint64_t cursor = 0, run_start = 0, run_length = 0;
+    for (auto pos : live) {
+        auto index = std::uint64_t((pos.y - y) * width + (pos.x - x));
+        if (run_length > 0 && index < run_start + run_length) {
+            continue;
+        } else if (run_length > 0 && index == run_start + run_length) {
+            run_length++;
+            continue;
+        }
+        if (run_length > 0) {
+            put_varint(data, run_start - cursor);
+            put_varint(data, run_length);
+            cursor = run_start + run_length;
+        }
+        run_start = index;
+        run_length = 1;
+    }
+    if (run_length > 0) {
+        put_varint(data, run_start - cursor);
+        put_varint(data, run_length);
+    }
+    return data;
+}
+
+static std::vector<char> encode_bits(const std::vector<Position> &live,
+                                     std::int64_t x, std::int64_t y,
+                                     std::int64_t width, std::int64_t height) {
+    auto row_words = (width + word_bits - 1) / word_bits;
+    std::vector<std::uint64_t> words(row_words * height, 0);
+    for (auto pos : live) {
+        auto cell_x = pos.x - x;
+        words[(pos.y - y) * row_words + cell_x / word_bits] |=
+            std::uint64_t(1) << (cell_x % word_bits);
+    }
+    std::vector<char> data(words.size() * sizeof(std::uint64_t));
+    std::memcpy(data.data(), words.data(), data.size());
+    return data;
+}
+
+bool save_checkpoint(const std::string &path, Checkpoint &checkpoint) {
+    auto &live = checkpoint.snapshot.live;
+    std::sort(live.begin(), live.end(), [](Position lhs, Position rhs) {
+        return lhs.y < rhs.y || (lhs.y == rhs.y && lhs.x < rhs.x);
+    });
+
+    CheckpointHeader header = {};
+    std::memcpy(header.magic, checkpoint_magic, sizeof(header.magic));
+    header.version = checkpoint_version;
+    header.width = static_cast<std::uint32_t>(checkpoint.width);
+    header.height = static_cast<std::uint32_t>(checkpoint.height);
+    header.rule = checkpoint.rule.mask;
+    header.topology = static_cast<std::uint32_t>(checkpoint.topology);
+    header.generation =
+        static_cast<std::uint64_t>(std::max<std::int64_t>(
+            checkpoint.snapshot.generation, 0));
+    header.population = live.size();
+
+    std::vector<char> data;
+    if (!live.empty()) {
+        std::int64_t x_min = live.front().x, x_max = x_min;
+        for (auto pos : live) {
+            x_min = std::min<std::int64_t>(x_min, pos.x);
+            x_max = std::max<std::int64_t>(x_max, pos.x);
+        }
+        std::int64_t y_min = live.front().y, y_max = live.back().y;
+        auto width = x_max - x_min + 1, height = y_max - y_min + 1;
+        header.x = static_cast<std::int32_t>(x_min);
+        header.y = static_cast<std::int32_t>(y_min);
+        header.cells_width = static_cast<std::uint32_t>(width);
+        header.cells_height = static_cast<std::uint32_t>(height);
+
+        // Dense boards pack smaller, sparse ones such as a few gliders far
+        // apart run smaller
+        data = encode_runs(live, x_min, y_min, width);
+        auto bits_size = std::uint64_t((width + word_bits - 1) / word_bits) *
+                         std::uint64_t(height) * sizeof(std::uint64_t);
+        header.encoding = CheckpointEncoding::runs;
+        if (bits_size <= data.size()) {
+            data = encode_bits(live, x_min, y_min, width, height);
+            header.encoding = CheckpointEncoding::bits;
+        }
+    }
+    header.data_size = data.size();
+
+    // Written aside and moved over the old checkpoint, so a crash part way
+    // through leaves the last one intact
+    auto partial = path + ".partial";
+    {
+        std::ofstream file(partial, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file.flush()) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(partial, path, error);
+    return !error;
+}
+
+CheckpointFile::CheckpointFile() : header(), cells(nullptr) {}
+
+bool CheckpointFile::open(const std::string &path) {
+    if (!file.open(path)) {
+        return false;
+    }
+    return view(file.data(), file.size());
+}
+
+bool CheckpointFile::view(const char *data, std::size_t size) {
+    if (size < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    cells = data + sizeof(header);
+
+    const std::int64_t int_max = std::numeric_limits<int>::max();
+    auto rule_mask = header.rule;
+    if (std::memcmp(header.magic, checkpoint_magic, sizeof(header.magic)) !=
+            0 ||
+        header.version < 1 || header.version > checkpoint_version ||
+        header.width > int_max || header.height > int_max ||
+        (rule_mask & ~0x01ff01ffu) != 0 || (rule_mask & 1) != 0 ||
+        header.topology >
+            static_cast<std::uint32_t>(Topology::klein_bottle) ||
+        header.data_size != size - sizeof(header)) {
+        return false;
+    }
+
+    // The bounding box has to fit in a Position
+    if (header.population == 0) {
+        return header.data_size == 0;
+    } else if (header.cells_width == 0 || header.cells_height == 0 ||
+               std::int64_t(header.x) + header.cells_width - 1 > int_max ||
+               std::int64_t(header.y) + header.cells_height - 1 > int_max) {
+        return false;
+    }
+    if (header.encoding == CheckpointEncoding::bits) {
+        std::uint64_t row_words =
+            (std::uint64_t(header.cells_width) + word_bits - 1) / word_bits;
+        return header.data_size ==
+               row_words * header.cells_height * sizeof(std::uint64_t);
+    }
+    return header.encoding == CheckpointEncoding::runs;
+}
+
+Rule CheckpointFile::rule() const {
+    return Rule(static_cast<std::uint16_t>(header.rule & 0xffff),
+                static_cast<std::uint16_t>(header.rule >> 16));
+}
+
+bool CheckpointFile::read(std::int64_t x, std::int64_t y, const CellBatch &f,
+                          const CellBox &clip) const {
+    CellBatcher out(x + header.x, y + header.y, f, clip);
+    std::uint64_t width = header.cells_width;
+    std::uint64_t n_cells = 0;
+
+    if (header.encoding == CheckpointEncoding::bits) {
+        auto row_words = (width + word_bits - 1) / word_bits;
+        auto p = cells;
+        for (std::uint64_t row = 0; row < header.cells_height; row++) {
+            for (std::uint64_t i = 0; i < row_words; i++) {
+                std::uint64_t word;
+                std::memcpy(&word, p, sizeof(word));
+                p += sizeof(word);
+                while (word != 0) {
+                    auto cell_x = i * word_bits + lowest_bit(word);
+                    if (cell_x >= width) {
+                        return false;
+                    }
+                    out.add(cell_x, row);
+                    n_cells++;
+                    word &= word - 1;
+                }
+            }
+        }
+    } else {
+        auto total = width * header.cells_height;
+        std::uint64_t cursor = 0, dead, alive;
+        for (auto p = cells, end = cells + header.data_size; p < end;) {
+            if (!get_varint(p, end, dead) || !get_varint(p, end, alive) ||
+                alive == 0 || dead > total - cursor ||
+                alive > total - cursor - dead) {
+                return false;
+            }
+            cursor += dead;
+            // A run can carry on past the end of a row
+            while (alive > 0) {
+                auto column = cursor % width;
+                auto n = std::min(alive, width - column);
+                out.add(column, cursor / width, n);
+                cursor += n;
+                alive -= n;
+                n_cells += n;
+            }
+        }
+    }
+    out.flush();
+    return n_cells == header.population;
+}
+
+CheckpointWriter::CheckpointWriter(const std::string &path_)
+    : path(path_), thread([this] { work(); }) {}
+
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    thread.join();
+}
+
+void CheckpointWriter::write() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        busy.store(true, std::memory_order_relaxed);
+    }
+    wake.notify_all();
+}
+
+void CheckpointWriter::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return !busy.load(std::memory_order_relaxed); });
+}
+
+void CheckpointWriter::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] {
+            return stopping || busy.load(std::memory_order_relaxed);
+        });
+        if (!busy.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        // pending is left alone by the caller until busy is cleared
+        lock.unlock();
+        if (save_checkpoint(path, pending)) {
+            n_written++;
+        } else {
+            n_failed++;
+        }
+        lock.lock();
+        busy.store(false, std::memory_order_release);
+        done.notify_all();
+    }
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "cell_batcher.hpp"
+#include "mapped_file.hpp"
+#include "rule.hpp"
+#include "snapshot.hpp"
+#include "topology.hpp"
+
+/**
+ * Everything needed to resume a run: the size of the arena, the rule, how
+ * its edges meet and the live cells of a generation.
+ */
+struct Checkpoint {
+    int width = 0;
+    int height = 0;
+    Rule rule = conway_rule;
+    Topology topology = Topology::dead;
+    Snapshot snapshot;
+};
+
+/**
+ * How the cells of a checkpoint file are stored.
+ */
+enum class CheckpointEncoding : std::uint32_t {
+    // One bit per cell of the bounding box of the live cells, in rows of
+    // 64-bit words
+    bits = 0,
+    // Alternating lengths of dead and live runs through the bounding box in
+    // row order, as LEB128 varints
+    runs = 1,
+};
+
+/**
+ * The fixed size header at the start of a checkpoint file, followed by
+ * data_size bytes of cells. Stored in the byte order of the machine that
+ * wrote it; a file from a machine of the other order fails the version
+ * check.
+ */
+struct CheckpointHeader {
+    char magic[8];
+    std::uint32_t version;
+    CheckpointEncoding encoding;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t rule;
+    // A Topology, always dead in version 1 files
+    std::uint32_t topology;
+    std::uint64_t generation;
+    std::uint64_t population;
+    // The bounding box of the live cells
+    std::int32_t x;
+    std::int32_t y;
+    std::uint32_t cells_width;
+    std::uint32_t cells_height;
+    std::uint64_t data_size;
+};
+
+static_assert(sizeof(CheckpointHeader) == 72,
+              "has no padding and keeps the cells 64-bit aligned");
+
+/**
+ * Write a checkpoint to path, replacing it only once the whole file has been
+ * written. The cells are stored whichever of bit-packed or run-length is
+ * smaller. The snapshot's cells are sorted into row order. Returns false if
+ * the file can't be written.
+ */
+bool save_checkpoint(const std::string &path, Checkpoint &checkpoint);
+
+/**
+ * A checkpoint file, read straight from a memory mapping.
+ *
+ * Opening a checkpoint only checks its header. The cells are decoded from the
+ * mapping as they are read and handed over in batches, the same way as a
+ * PatternFile.
+ */
+class CheckpointFile {
+  public:
+    CheckpointFile();
+    CheckpointFile(const CheckpointFile &) = delete;
+    CheckpointFile &operator=(const CheckpointFile &) = delete;
+
+    /**
+     * Map the file at path and check its header. Returns false if it can't
+     * be mapped or isn't a checkpoint.
+     */
+    bool open(const std::string &path);
+
+    /**
+     * Check the header of a checkpoint already in memory, which must outlive
+     * the CheckpointFile.
+     */
+    bool view(const char *data, std::size_t size);
+
+    int width() const { return static_cast<int>(header.width); }
+    int height() const { return static_cast<int>(header.height); }
+    Rule rule() const;
+    Topology topology() const { return Topology(header.topology); }
+    std::uint64_t generation() const { return header.generation; }
+    std::uint64_t population() const { return header.population; }
+    CheckpointEncoding encoding() const { return header.encoding; }
+
+    /**
+     * Decode the live cells, passing them to f in batches, moved by x, y.
+     * Cells outside of clip, by default the range of a Position, are skipped.
+     * Returns false if the cells are malformed, f may already have been
+     * called with the ones before the error.
+     */
+    bool read(std::int64_t x, std::int64_t y, const CellBatch &f,
+              const CellBox &clip = CellBox::positions()) const;
+
+  private:
+    MappedFile file;
+    CheckpointHeader header;
+    const char *cells;
+};
+
+/**
+ * Writes checkpoints on a background thread, so the thread stepping the
+ * world only pays for copying its live cells into checkpoint().
+ *
+ * There is a single checkpoint in flight at a time. While it is being
+ * written ready() is false and the caller should carry on without one
+ * rather than wait.
+ */
+class CheckpointWriter {
+  public:
+    explicit CheckpointWriter(const std::string &path_);
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter &) = delete;
+    CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+    /**
+     * Whether the last checkpoint has been written, so checkpoint() can be
+     * filled in again.
+     */
+    bool ready() const { return !busy.load(std::memory_order_acquire); }
+
+    /**
+     * The checkpoint to fill in before calling write(), only while ready().
+     */
+    Checkpoint &checkpoint() { return pending; }
+
+    /**
+     * Start writing checkpoint() in the background.
+     */
+    void write();
+
+    /**
+     * Wait for the checkpoint being written, if any.
+     */
+    void wait();
+
+    /**
+     * Number of checkpoints written, and that couldn't be written.
+     */
+    std::size_t written() const { return n_written; }
+    std::size_t failed() const { return n_failed; }
+
+  private:
+    void work();
+
+    std::string path;
+    Checkpoint pending;
+    std::atomic<bool> busy{false};
+    std::atomic<std::size_t> n_written{0};
+    std::atomic<std::size_t> n_failed{0};
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool stopping = false;
+    std::thread thread;
+};
@@ -0,0 +1,85 @@
+#include <cstddef>
+#include <filesystem>
+#include <random>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "bitgrid.hpp"
+#include "checkpoint.hpp"
+#include "components.hpp"
+#include "rule.hpp"
+#include "systems.hpp"
+
+/**
+ * A dim x dim soup, about a third alive, stepped for a few generations so
+ * it is no longer uniformly random.
+ */
+static void make_checkpoint(int dim, Checkpoint &checkpoint) {
+    BitGrid grid(dim, dim);
+    std::mt19937 rand_gen(42);
+    std::bernoulli_distribution alive(1.0 / 3);
+    for (auto x = 0; x < dim; x++) {
+        for (auto y = 0; y < dim; y++) {
+            grid.set(x, y, alive(rand_gen));
+        }
+    }
+    for (auto generation = 0; generation < 16; generation++) {
+        grid.step();
+        grid.swap();
+    }
+    checkpoint.width = dim;
+    checkpoint.height = dim;
+    checkpoint.rule = conway_rule;
+    snapshot_system(grid, checkpoint.snapshot);
+    checkpoint.snapshot.generation = grid.generation();
+}
+
+static std::string checkpoint_path() {
+    return (std::filesystem::temp_directory_path() / "gol_bench.ckpt")
+        .string();
+}
+
+// What the writer thread does with each checkpoint, off the step loop
+static void BM_save_checkpoint(benchmark::State &state) {
+    Checkpoint checkpoint;
+    make_checkpoint(static_cast<int>(state.range(0)), checkpoint);
+    auto path = checkpoint_path();
+
+    for (auto _ : state) {
+        save_checkpoint(path, checkpoint);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) *
+                            state.range(0));
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_save_checkpoint)
+    ->Arg(1024)
+    ->Arg(4096)
+    ->Unit(benchmark::kMillisecond);
+
+// Restoring a checkpoint into a bit grid, to compare with the time taken to
+// step to it in BM_bitgrid_step
+static void BM_restore_checkpoint(benchmark::State &state) {
+    auto dim = static_cast<int>(state.range(0));
+    Checkpoint checkpoint;
+    make_checkpoint(dim, checkpoint);
+    auto path = checkpoint_path();
+    save_checkpoint(path, checkpoint);
+
+    for (auto _ : state) {
+        CheckpointFile file;
+        BitGrid grid(dim, dim);
+        if (!file.open(path) || !restore_grid(grid, file)) {
+            state.SkipWithError("couldn't restore the checkpoint");
+            break;
+        }
+        benchmark::DoNotOptimize(grid.get(0, 0));
+    }
+    state.SetItemsProcessed(state.iterations() * dim * dim);
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_restore_checkpoint)
+    ->Arg(1024)
+    ->Arg(4096)
+    ->Unit(benchmark::kMillisecond);
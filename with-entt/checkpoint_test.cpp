@@ -0,0 +1,269 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <doctest.h>
+
+#include "checkpoint.hpp"
+#include "components.hpp"
+#include "rule.hpp"
+#include "topology.hpp"
+
+static std::string temp_path(const char *name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static std::string read_file(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), {});
+}
+
+static std::set<Position> read_cells(const CheckpointFile &file,
+                                     std::int64_t x = 0, std::int64_t y = 0) {
+    std::set<Position> cells;
+    REQUIRE(file.read(x, y, [&](const Position *batch, std::size_t n) {
+        cells.insert(batch, batch + n);
+    }));
+    return cells;
+}
+
+/**
+ * Save a checkpoint of the given cells and read it back.
+ */
+static std::string round_trip(const std::set<Position> &live,
+                              CheckpointFile &file) {
+    Checkpoint checkpoint;
+    checkpoint.width = 300;
+    checkpoint.height = 200;
+    checkpoint.rule = highlife_rule;
+    checkpoint.snapshot.generation = 12345;
+    checkpoint.snapshot.live.assign(live.begin(), live.end());
+    // Saving doesn't depend on the order the cells come in
+    std::shuffle(checkpoint.snapshot.live.begin(),
+                 checkpoint.snapshot.live.end(), std::mt19937(7));
+
+    auto path = temp_path("gol_checkpoint_test.ckpt");
+    REQUIRE(save_checkpoint(path, checkpoint));
+    auto contents = read_file(path);
+    std::filesystem::remove(path);
+    REQUIRE(file.view(contents.data(), contents.size()));
+    REQUIRE(file.width() == 300);
+    REQUIRE(file.height() == 200);
+    REQUIRE(file.rule() == highlife_rule);
+    REQUIRE(file.topology() == Topology::dead);
+    REQUIRE(file.generation() == 12345);
+    REQUIRE(file.population() == live.size());
+    REQUIRE(read_cells(file) == live);
+    return contents;
+}
+
+TEST_SUITE("checkpoints") {
+    TEST_CASE("an empty board round trips") {
+        CheckpointFile file;
+        auto contents = round_trip({}, file);
+        REQUIRE(contents.size() == sizeof(CheckpointHeader));
+    }
+
+    TEST_CASE("dense boards are stored bit-packed") {
+        std::set<Position> live;
+        std::mt19937 rand_gen(3);
+        std::bernoulli_distribution alive(0.4);
+        for (auto x = 0; x < 300; x++) {
+            for (auto y = 0; y < 200; y++) {
+                if (alive(rand_gen)) {
+                    live.emplace(x, y);
+                }
+            }
+        }
+
+        CheckpointFile file;
+        auto contents = round_trip(live, file);
+        REQUIRE(file.encoding() == CheckpointEncoding::bits);
+        REQUIRE(contents.size() ==
+                sizeof(CheckpointHeader) + 5 * 200 * sizeof(std::uint64_t));
+    }
+
+    TEST_CASE("sparse boards are stored as runs") {
+        // A block running past the end of its rows, and cells far apart
+        // and outside of the arena, as a hashlife universe can have
+        std::set<Position> live = {Position(-1000000, -5),
+                                   Position(2000000000, 1500000)};
+        for (auto x = 10; x < 20; x++) {
+            for (auto y = 10; y < 20; y++) {
+                live.emplace(x, y);
+            }
+        }
+
+        // The file views the contents, which must outlive it
+        CheckpointFile file;
+        auto contents = round_trip(live, file);
+        REQUIRE(file.encoding() == CheckpointEncoding::runs);
+
+        SUBCASE("and read around an origin") {
+            std::set<Position> moved;
+            for (auto pos : live) {
+                moved.emplace(pos.x + 3, pos.y - 4);
+            }
+            REQUIRE(read_cells(file, 3, -4) == moved);
+        }
+    }
+
+    TEST_CASE("runs carry on from the end of one row to the next") {
+        std::set<Position> live;
+        for (auto x = 0; x < 128; x++) {
+            live.emplace(x, 7);
+        }
+        live.emplace(0, 8);
+
+        CheckpointFile file;
+        round_trip(live, file);
+    }
+
+    TEST_CASE("malformed checkpoints are rejected") {
+        Checkpoint checkpoint;
+        checkpoint.width = 8;
+        checkpoint.height = 8;
+        checkpoint.snapshot.live = {Position(1, 1), Position(5, 6)};
+        auto path = temp_path("gol_checkpoint_bad.ckpt");
+        REQUIRE(save_checkpoint(path, checkpoint));
+        auto contents = read_file(path);
+        std::filesystem::remove(path);
+
+        CheckpointFile file;
+        REQUIRE(file.view(contents.data(), contents.size()));
+        REQUIRE(file.rule() == conway_rule);
+
+        SUBCASE("truncated") {
+            REQUIRE_FALSE(file.view(contents.data(), contents.size() - 1));
+            REQUIRE_FALSE(file.view(contents.data(), 10));
+        }
+        SUBCASE("not a checkpoint") {
+            contents[0] = 'X';
+            REQUIRE_FALSE(file.view(contents.data(), contents.size()));
+        }
+        SUBCASE("a rule with births on zero neighbours") {
+            contents[offsetof(CheckpointHeader, rule)] |= 1;
+            REQUIRE_FALSE(file.view(contents.data(), contents.size()));
+        }
+        SUBCASE("an unknown topology") {
+            contents[offsetof(CheckpointHeader, topology)] = 3;
+            REQUIRE_FALSE(file.view(contents.data(), contents.size()));
+        }
+        SUBCASE("a newer version") {
+            contents[offsetof(CheckpointHeader, version)]++;
+            REQUIRE_FALSE(file.view(contents.data(), contents.size()));
+        }
+        SUBCASE("cells that don't match the population") {
+            contents[offsetof(CheckpointHeader, population)]++;
+            REQUIRE(file.view(contents.data(), contents.size()));
+            REQUIRE_FALSE(file.read(0, 0, [](const Position *,
+                                             std::size_t) {}));
+        }
+        SUBCASE("runs beyond the bounding box") {
+            REQUIRE(file.encoding() == CheckpointEncoding::runs);
+            contents[sizeof(CheckpointHeader) + 2] = 100;
+            REQUIRE(file.view(contents.data(), contents.size()));
+            REQUIRE_FALSE(file.read(0, 0, [](const Position *,
+                                             std::size_t) {}));
+        }
+    }
+
+    TEST_CASE("the topology round trips") {
+        for (auto topology : {Topology::torus, Topology::klein_bottle}) {
+            Checkpoint checkpoint;
+            checkpoint.width = 8;
+            checkpoint.height = 8;
+            checkpoint.topology = topology;
+            checkpoint.snapshot.live = {Position(0, 0), Position(7, 7)};
+            auto path = temp_path("gol_checkpoint_topology.ckpt");
+            REQUIRE(save_checkpoint(path, checkpoint));
+            auto contents = read_file(path);
+            std::filesystem::remove(path);
+
+            CheckpointFile file;
+            REQUIRE(file.view(contents.data(), contents.size()));
+            REQUIRE(file.topology() == topology);
+
+            // Version 1 didn't store it, and only ran with a dead border
+            std::uint32_t version = 1;
+            std::memcpy(&contents[offsetof(CheckpointHeader, version)],
+                        &version, sizeof(version));
+            std::memset(&contents[offsetof(CheckpointHeader, topology)], 0,
+                        sizeof(std::uint32_t));
+            REQUIRE(file.view(contents.data(), contents.size()));
+            REQUIRE(file.topology() == Topology::dead);
+        }
+    }
+
+    TEST_CASE("checkpoints are restored from a mapping") {
+        Checkpoint checkpoint;
+        checkpoint.width = 8;
+        checkpoint.height = 8;
+        checkpoint.snapshot.live = {Position(1, 1), Position(5, 6)};
+        auto path = temp_path("gol_checkpoint_mapped.ckpt");
+        REQUIRE(save_checkpoint(path, checkpoint));
+
+        CheckpointFile file;
+        REQUIRE(file.open(path));
+        REQUIRE(read_cells(file) ==
+                std::set<Position>{Position(1, 1), Position(5, 6)});
+        std::filesystem::remove(path);
+        REQUIRE_FALSE(file.open(path));
+    }
+}
+
+TEST_SUITE("CheckpointWriter") {
+    TEST_CASE("writes checkpoints in the background") {
+        auto path = temp_path("gol_checkpoint_writer.ckpt");
+        CheckpointWriter writer(path);
+        for (auto generation = 1; generation <= 3; generation++) {
+            REQUIRE(writer.ready());
+            writer.checkpoint().width = 4;
+            writer.checkpoint().height = 4;
+            writer.checkpoint().snapshot.generation = generation;
+            writer.checkpoint().snapshot.live = {Position(generation, 0)};
+            writer.write();
+            writer.wait();
+        }
+        REQUIRE(writer.written() == 3);
+        REQUIRE(writer.failed() == 0);
+
+        // Each checkpoint replaces the last
+        CheckpointFile file;
+        REQUIRE(file.open(path));
+        REQUIRE(file.generation() == 3);
+        REQUIRE(read_cells(file) == std::set<Position>{Position(3, 0)});
+        std::filesystem::remove(path);
+    }
+
+    TEST_CASE("counts checkpoints that can't be written") {
+        CheckpointWriter writer(temp_path("gol_no_such_dir/gol.ckpt"));
+        writer.write();
+        writer.wait();
+        REQUIRE(writer.written() == 0);
+        REQUIRE(writer.failed() == 1);
+    }
+
+    TEST_CASE("finishes the checkpoint being written when destroyed") {
+        auto path = temp_path("gol_checkpoint_last.ckpt");
+        {
+            CheckpointWriter writer(path);
+            writer.checkpoint().width = 4;
+            writer.checkpoint().height = 4;
+            writer.write();
+        }
+        CheckpointFile file;
+        REQUIRE(file.open(path));
+        std::filesystem::remove(path);
+    }
+}
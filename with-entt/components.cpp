@@ -10,6 +10,10 @@ bool operator!=(const Position &lhs, const Position &rhs) {
     return !(lhs == rhs);
 }
 
+bool operator<(const Position &lhs, const Position &rhs) {
+    return lhs.x < rhs.x || (lhs.x == rhs.x && lhs.y < rhs.y);
+}
+
 std::ostream &operator<<(std::ostream &os, const Position &pos) {
     os << "(" << pos.x << ", " << pos.y << ")";
     return os;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 #include <entt/entt.hpp>
@@ -9,7 +10,7 @@ struct Position {
     int y;
 
     Position() {}
-    Position(int x_, int y_) : x(x_), y(y_) {}
+    constexpr Position(int x_, int y_) : x(x_), y(y_) {}
 };
 
 typedef std::vector<entt::entity> Neighbours;
@@ -19,11 +20,27 @@ bool operator!=(const Position &lhs, const Position &rhs);
 std::ostream &operator<<(std::ostream &os, const Position &pos);
 bool operator<(const Position &lhs, const Position &rhs);
 
+/**
+ * Hash a position by packing it into one 64-bit word and mixing it with the
+ * MurmurHash3 finaliser, so every bit of x and y affects every bit of the
+ * hash.
+ */
+inline std::uint64_t position_hash(const Position &pos) {
+    auto key = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(pos.x))
+                << 32) |
+               static_cast<std::uint32_t>(pos.y);
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
 namespace std {
 template <> struct hash<Position> {
     inline size_t operator()(const Position &pos) const {
-        std::hash<int> int_hasher;
-        return int_hasher(pos.x) ^ int_hasher(pos.y);
+        return static_cast<size_t>(position_hash(pos));
     }
 };
 } // namespace std
@@ -2,6 +2,7 @@
 
 #include <sstream>
 #include <random>
+#include <unordered_set>
 #include <vector>
 
 #include <doctest.h>
@@ -45,6 +46,20 @@ TEST_CASE("position inequality") {
   REQUIRE(pos1 != pos2);
 }
 
+TEST_CASE("position hashes do not collide on diagonals or mirrors") {
+    std::unordered_set<std::size_t> hashes;
+    for (auto i = -50; i < 50; i++) {
+        hashes.insert(std::hash<Position>()(Position(i, i)));
+        hashes.insert(std::hash<Position>()(Position(i, -i)));
+        hashes.insert(std::hash<Position>()(Position(i, 7)));
+        hashes.insert(std::hash<Position>()(Position(7, i)));
+    }
+
+    // Only the positions generated more than once share a hash: (0, 0),
+    // (-7, 7), (7, -7) twice and (7, 7) three times
+    REQUIRE(hashes.size() == 4 * 100 - 5);
+}
+
 TEST_CASE("position output stream") {
     std::random_device rand_dev;
     std::mt19937 rand_gen(rand_dev());
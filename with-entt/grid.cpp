@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <limits>
+
+#include <entt/entt.hpp>
+
+#include "components.hpp"
+#include "grid.hpp"
+#include "topology.hpp"
+#include "utils.hpp"
+
+// Margin around the positions' bounding box. Positions one cell outside of
+// the box can still have live neighbours, and their neighbours are one
+// further out again.
+static const int margin = 2;
+
+/**
+ * The topology set in the registry's context, or a dead border if there
+ * isn't one.
+ */
+static Topology registry_topology(entt::registry &registry) {
+    auto topology = registry.try_ctx<Topology>();
+    return topology ? *topology : Topology::dead;
+}
+
+LiveGrid::~LiveGrid() { unwatch(); }
+
+void LiveGrid::rebuild(entt::registry &registry) {
+    watch(registry);
+    if (stale_positions) {
+        index_positions(registry);
+    }
+
+    std::fill(alive.begin(), alive.end(), 0);
+    registry.view<Position, entt::tag<"is_alive"_hs>>().each(
+        [&](auto &pos, auto _) { alive[index(pos)] = 1; });
+    seen_changes = alive_changes;
+    edges = registry_topology(registry);
+    fill_border();
+
+    tile_marked.assign(tile_count(), 1);
+    synced = true;
+}
+
+bool LiveGrid::in_sync(entt::registry &registry) const {
+    return synced && watched == &registry && !stale_positions &&
+           seen_changes == alive_changes &&
+           registry_topology(registry) == edges;
+}
+
+void LiveGrid::set_alive(Position pos, bool is_alive) {
+    auto &cell = alive[index(pos)];
+    if (cell == is_alive) {
+        return;
+    }
+    cell = is_alive;
+    seen_changes++;
+    mark_tiles_around(pos);
+
+    // Only cells on the board's edges have copies past the other edges
+    auto x = pos.x - min_x - margin, y = pos.y - min_y - margin;
+    auto arena_width = width - 2 * margin, arena_height = height - 2 * margin;
+    if (edges == Topology::dead ||
+        (x > 0 && x < arena_width - 1 && y > 0 && y < arena_height - 1)) {
+        return;
+    }
+    for (auto dy : {-arena_height, 0, arena_height}) {
+        // Crossing the top or bottom of a Klein bottle flips the board over
+        auto from_x = dy != 0 && edges == Topology::klein_bottle
+                          ? arena_width - 1 - x
+                          : x;
+        for (auto dx : {-arena_width, 0, arena_width}) {
+            Position copy(from_x + dx, y + dy);
+            if ((dx == 0 && dy == 0) || copy.x < -1 ||
+                copy.x > arena_width || copy.y < -1 ||
+                copy.y > arena_height ||
+                wrap_position(edges, copy, arena_width, arena_height) !=
+                    Position(x, y)) {
+                continue;
+            }
+            copy = Position(copy.x + min_x + margin, copy.y + min_y + margin);
+            alive[index(copy)] = is_alive;
+            mark_tiles_around(copy);
+        }
+    }
+}
+
+/**
+ * Copy the cells on each edge of the board into the ring of cells around it,
+ * from where they wrap to.
+ */
+void LiveGrid::fill_border() {
+    if (edges == Topology::dead || width == 0) {
+        return;
+    }
+    auto arena_width = width - 2 * margin, arena_height = height - 2 * margin;
+    auto copy = [&](int x, int y) {
+        auto from = wrap_position(edges, Position(x, y), arena_width,
+                                  arena_height);
+        alive[index(Position(x + min_x + margin, y + min_y + margin))] =
+            alive[index(
+                Position(from.x + min_x + margin, from.y + min_y + margin))];
+    };
+    for (auto x = -1; x <= arena_width; x++) {
+        copy(x, -1);
+        copy(x, arena_height);
+    }
+    for (auto y = 0; y < arena_height; y++) {
+        copy(-1, y);
+        copy(arena_width, y);
+    }
+}
+
+/**
+ * Mark the tile of a cell and the tiles around it active.
+ */
+void LiveGrid::mark_tiles_around(Position pos) {
+    // A change on the edge of a tile can change the cells in the next tile
+    // along, so the surrounding tiles are marked too
+    auto tile_x = (pos.x - min_x - 1) / tile_size;
+    auto tile_y = (pos.y - min_y - 1) / tile_size;
+    auto n_tiles_x = tiles_x();
+    auto n_tiles_y = tile_count() / n_tiles_x;
+    for (auto y = std::max(tile_y - 1, 0);
+         y <= std::min(tile_y + 1, n_tiles_y - 1); y++) {
+        for (auto x = std::max(tile_x - 1, 0);
+             x <= std::min(tile_x + 1, n_tiles_x - 1); x++) {
+            tile_marked[y * n_tiles_x + x] = 1;
+        }
+    }
+}
+
+const std::vector<int> &LiveGrid::take_active_tiles() {
+    active_tiles.clear();
+    for (auto tile = 0; tile < static_cast<int>(tile_marked.size()); tile++) {
+        if (tile_marked[tile]) {
+            active_tiles.push_back(tile);
+            tile_marked[tile] = 0;
+        }
+    }
+    return active_tiles;
+}
+
+/**
+ * Connect to the registry's hooks, leaving the one watched before. A registry
+ * that wasn't already watched could have changed in any way, so its positions
+ * are indexed again.
+ */
+void LiveGrid::watch(entt::registry &registry) {
+    if (watched == &registry) {
+        return;
+    }
+    unwatch();
+    registry.on_construct<Position>()
+        .connect<&LiveGrid::positions_changed>(*this);
+    registry.on_replace<Position>()
+        .connect<&LiveGrid::positions_changed>(*this);
+    registry.on_destroy<Position>()
+        .connect<&LiveGrid::position_destroyed>(*this);
+    registry.on_construct<entt::tag<"is_alive"_hs>>()
+        .connect<&LiveGrid::alive_assigned>(*this);
+    registry.on_destroy<entt::tag<"is_alive"_hs>>()
+        .connect<&LiveGrid::alive_removed>(*this);
+    watched = &registry;
+    stale_positions = true;
+}
+
+void LiveGrid::unwatch() {
+    if (!watched) {
+        return;
+    }
+    watched->on_construct<Position>()
+        .disconnect<&LiveGrid::positions_changed>(*this);
+    watched->on_replace<Position>()
+        .disconnect<&LiveGrid::positions_changed>(*this);
+    watched->on_destroy<Position>()
+        .disconnect<&LiveGrid::position_destroyed>(*this);
+    watched->on_construct<entt::tag<"is_alive"_hs>>()
+        .disconnect<&LiveGrid::alive_assigned>(*this);
+    watched->on_destroy<entt::tag<"is_alive"_hs>>()
+        .disconnect<&LiveGrid::alive_removed>(*this);
+    watched = nullptr;
+}
+
+void LiveGrid::index_positions(entt::registry &registry) {
+    auto positions = registry.view<Position>();
+    stale_positions = false;
+
+    int max_x = std::numeric_limits<int>::min();
+    int max_y = std::numeric_limits<int>::min();
+    min_x = std::numeric_limits<int>::max();
+    min_y = std::numeric_limits<int>::max();
+    for (auto entity : positions) {
+        auto &pos = registry.get<Position>(entity);
+        min_x = std::min(min_x, pos.x);
+        min_y = std::min(min_y, pos.y);
+        max_x = std::max(max_x, pos.x);
+        max_y = std::max(max_y, pos.y);
+    }
+
+    if (max_x < min_x) {
+        // No positions, leave an empty grid at the origin so that bounds
+        // checks against it can't overflow
+        min_x = min_y = 0;
+        width = height = 0;
+        entities.clear();
+        alive.clear();
+        return;
+    }
+
+    min_x -= margin;
+    min_y -= margin;
+    width = max_x - min_x + margin + 1;
+    height = max_y - min_y + margin + 1;
+
+    auto size = static_cast<std::size_t>(width) * height;
+    entities.assign(size, entt::null);
+    alive.assign(size, 0);
+    for (auto entity : positions) {
+        entities[index(registry.get<Position>(entity))] = entity;
+    }
+}
+
+entt::entity LiveGrid::at(Position pos) const {
+    if (!in_bounds(pos, 0) || !alive[index(pos)]) {
+        return entt::null;
+    }
+    return entities[index(pos)];
+}
+
+int LiveGrid::count_neighbours(Position pos) const {
+    if (!in_bounds(pos, 1)) {
+        return 0;
+    }
+
+    auto i = index(pos);
+    auto above = &alive[i - width], row = &alive[i], below = &alive[i + width];
+    return above[-1] + above[0] + above[1] + row[-1] + row[1] + below[-1] +
+           below[0] + below[1];
+}
+
+int LiveGrid::tile_count() const {
+    if (width == 0) {
+        return 0;
+    }
+    auto tiles_y = (height - 2 + tile_size - 1) / tile_size;
+    return tiles_x() * tiles_y;
+}
+
+bool LiveGrid::in_bounds(Position pos, int inset) const {
+    return pos.x >= min_x + inset && pos.x < min_x + width - inset &&
+           pos.y >= min_y + inset && pos.y < min_y + height - inset;
+}
+
+int LiveGrid::index(Position pos) const {
+    return (pos.y - min_y) * width + (pos.x - min_x);
+}
+
+LiveGrid &live_grid(entt::registry &registry) {
+    if (auto grid = registry.try_ctx<LiveGrid>()) {
+        return *grid;
+    }
+    return registry.set<LiveGrid>();
+}
+
+SparseGrid::SparseGrid(int arena_x_max_, int arena_y_max_)
+    : arena_x_max(arena_x_max_), arena_y_max(arena_y_max_) {}
+
+void SparseGrid::rebuild(entt::registry &registry) {
+    cells.clear();
+    int min_x = std::numeric_limits<int>::max(), max_x = -1;
+    int min_y = std::numeric_limits<int>::max(), max_y = -1;
+    registry.view<Position, entt::tag<"is_alive"_hs>>().each(
+        [&](auto &pos, auto _) {
+            cells[pos].alive = true;
+            for (auto neighbour : find_possible_neighbours(pos)) {
+                cells[neighbour].neighbours++;
+            }
+            min_x = std::min(min_x, pos.x);
+            max_x = std::max(max_x, pos.x);
+            min_y = std::min(min_y, pos.y);
+            max_y = std::max(max_y, pos.y);
+        });
+
+    auto topology = registry_topology(registry);
+    if (topology == Topology::dead || max_x < 0) {
+        return;
+    }
+    // Only the sides of the ring next to a live cell can have counts
+    if (min_x == 0) {
+        for (auto y = min_y - 1; y <= max_y + 1; y++) {
+            fold_halo(topology, Position(-1, y));
+        }
+    }
+    if (max_x == arena_x_max - 1) {
+        for (auto y = min_y - 1; y <= max_y + 1; y++) {
+            fold_halo(topology, Position(arena_x_max, y));
+        }
+    }
+    if (min_y == 0) {
+        for (auto x = min_x - 1; x <= max_x + 1; x++) {
+            fold_halo(topology, Position(x, -1));
+        }
+    }
+    if (max_y == arena_y_max - 1) {
+        for (auto x = min_x - 1; x <= max_x + 1; x++) {
+            fold_halo(topology, Position(x, arena_y_max));
+        }
+    }
+}
+
+/**
+ * Move the count of a position in the ring around the arena to the cell it
+ * wraps to. A corner is on two sides, so it is left at zero to only be
+ * moved once.
+ */
+void SparseGrid::fold_halo(Topology topology, Position pos) {
+    auto cell = cells.find(pos);
+    if (!cell || cell->neighbours == 0) {
+        return;
+    }
+    auto neighbours = cell->neighbours;
+    cell->neighbours = 0;
+    cells[wrap_position(topology, pos, arena_x_max, arena_y_max)]
+        .neighbours += neighbours;
+}
+
+int SparseGrid::count_neighbours(Position pos) const {
+    auto cell = cells.find(pos);
+    return cell ? cell->neighbours : 0;
+}
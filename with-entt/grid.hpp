@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "components.hpp"
+#include "position_map.hpp"
+#include "rule.hpp"
+#include "topology.hpp"
+
+/**
+ * Dense spatial index from Position to the entity at that position and
+ * whether it is alive.
+ *
+ * The index covers the bounding box of the positioned entities plus a two
+ * cell margin, so any position that could have a live neighbour can count
+ * them with eight unchecked lookups. Positions outside of the box have no live
+ * neighbours. Cells are visited in square tiles so the lifecycle can be split
+ * across threads.
+ *
+ * With a Topology in the registry's context that wraps, the cells just
+ * outside the box mirror the cells on its opposite edges, so the same
+ * unchecked lookups count neighbours across the edges.
+ *
+ * Tiles with a cell that changed in the last round, and the tiles around
+ * them, are marked active. The step system only visits those, so settled
+ * regions of the board cost nothing.
+ *
+ * The positions are indexed once and the registry's hooks note when a
+ * Position is assigned, replaced or destroyed, so they are only indexed again
+ * after they change. Positions changed in place, rather than with
+ * registry.replace, aren't seen.
+ *
+ * The grid is kept between generations and the registry's hooks hold on to
+ * it, so it can't be copied or moved and can only be handed to the systems by
+ * reference.
+ */
+class LiveGrid {
+  public:
+    static const int tile_size = 64;
+
+    LiveGrid() = default;
+    LiveGrid(const LiveGrid &) = delete;
+    LiveGrid &operator=(const LiveGrid &) = delete;
+    ~LiveGrid();
+
+    /**
+     * Refresh which cells are alive from the entities tagged is_alive, and
+     * the topology from the registry's context. The positions are only
+     * re-indexed when they have changed since the last rebuild, and storage
+     * is reused between rebuilds.
+     */
+    void rebuild(entt::registry &registry);
+
+    /**
+     * Whether the grid still matches the registry, having only been changed
+     * through set_alive since it was rebuilt. Every is_alive tag added or
+     * removed is counted by the registry's hooks, and has to be matched by a
+     * cell changed with set_alive.
+     */
+    bool in_sync(entt::registry &registry) const;
+
+    /**
+     * Mark the grid as no longer matching the registry, for systems that
+     * change the is_alive tags themselves.
+     */
+    void invalidate() { synced = false; }
+
+    /**
+     * Record a change to a cell made alongside its is_alive tag, marking its
+     * tile and the tiles around it active for the next round. A cell on the
+     * edge of a wrapped board also updates its copies past the other edges.
+     */
+    void set_alive(Position pos, bool is_alive);
+
+    /**
+     * Collect the tiles marked active since the last call, clearing the
+     * marks. Every tile is active after a rebuild.
+     */
+    const std::vector<int> &take_active_tiles();
+
+    /**
+     * Number of tiles collected by the last take_active_tiles.
+     */
+    std::size_t active_tile_count() const { return active_tiles.size(); }
+
+    /**
+     * The live entity at the given position or entt::null.
+     */
+    entt::entity at(Position pos) const;
+
+    /**
+     * Number of live cells in the eight cells surrounding the given position.
+     */
+    int count_neighbours(Position pos) const;
+
+    /**
+     * Number of tiles covering the board.
+     */
+    int tile_count() const;
+
+    /**
+     * Call f with each entity in the given tile, whether it is alive and its
+     * number of live neighbours.
+     */
+    template <typename F> void each_in_tile(int tile, F f) const {
+        auto x_begin = 1 + (tile % tiles_x()) * tile_size;
+        auto y_begin = 1 + (tile / tiles_x()) * tile_size;
+        auto x_end = std::min(x_begin + tile_size, width - 1);
+        auto y_end = std::min(y_begin + tile_size, height - 1);
+
+        for (auto y = y_begin; y < y_end; y++) {
+            auto i = y * width + x_begin;
+            for (auto x = x_begin; x < x_end; x++, i++) {
+                auto entity = entities[i];
+                if (entity == entt::null) {
+                    continue;
+                }
+                auto above = &alive[i - width], row = &alive[i],
+                     below = &alive[i + width];
+                int neighbour_count = above[-1] + above[0] + above[1] +
+                                      row[-1] + row[1] + below[-1] +
+                                      below[0] + below[1];
+                f(entity, alive[i] != 0, neighbour_count);
+            }
+        }
+    }
+
+  private:
+    void watch(entt::registry &registry);
+    void unwatch();
+    void positions_changed(entt::registry &, entt::entity, Position &) {
+        stale_positions = true;
+    }
+    void position_destroyed(entt::registry &, entt::entity) {
+        stale_positions = true;
+    }
+    void alive_assigned(entt::registry &, entt::entity,
+                        entt::tag<"is_alive"_hs> &) {
+        alive_changes++;
+    }
+    void alive_removed(entt::registry &, entt::entity) { alive_changes++; }
+    void index_positions(entt::registry &registry);
+    void fill_border();
+    void mark_tiles_around(Position pos);
+    bool in_bounds(Position pos, int inset) const;
+    int index(Position pos) const;
+    int tiles_x() const { return (width - 2 + tile_size - 1) / tile_size; }
+
+    int min_x = 0;
+    int min_y = 0;
+    int width = 0;
+    int height = 0;
+    // The registry whose hooks are connected, and whether its positions have
+    // changed since they were indexed
+    entt::registry *watched = nullptr;
+    bool stale_positions = true;
+    std::vector<entt::entity> entities;
+    std::vector<std::uint8_t> alive;
+    // Changes to the is_alive tags, and how many of them the grid has seen
+    std::uint64_t alive_changes = 0;
+    std::uint64_t seen_changes = 0;
+    Topology edges = Topology::dead;
+    bool synced = false;
+    // Tiles to visit next round, and the tiles being visited this round
+    std::vector<std::uint8_t> tile_marked;
+    std::vector<int> active_tiles;
+};
+
+/**
+ * The live grid kept alongside the registry, created on first use.
+ */
+LiveGrid &live_grid(entt::registry &registry);
+
+/**
+ * Hashed neighbour counts for a registry in sparse mode, where only live cells
+ * are entities.
+ *
+ * Memory is proportional to the live cells and their neighbours rather than
+ * the area of the arena. Births are limited to the arena, matching the dense
+ * registry where no entity exists outside of it. On a wrapped board the
+ * neighbours of cells on the edges are counted where they wrap to.
+ */
+class SparseGrid {
+  public:
+    SparseGrid(int arena_x_max_, int arena_y_max_);
+    SparseGrid(const SparseGrid &) = delete;
+    SparseGrid &operator=(const SparseGrid &) = delete;
+    SparseGrid(SparseGrid &&) = default;
+    SparseGrid &operator=(SparseGrid &&) = default;
+
+    /**
+     * Rebuild the counts from the entities tagged is_alive, with the
+     * topology in the registry's context.
+     */
+    void rebuild(entt::registry &registry);
+
+    /**
+     * Number of live cells in the eight cells surrounding the given position.
+     */
+    int count_neighbours(Position pos) const;
+
+    /**
+     * Call f with every dead position in the arena with a number of live
+     * neighbours the rule has a birth for. Only positions next to a live cell
+     * are visited, so the rule must not have births with no neighbours.
+     */
+    template <typename RuleT, typename F>
+    void each_birth(const RuleT &rule, F f) const {
+        cells.each([&](const Position &pos, const Cell &cell) {
+            if (!cell.alive && rule.next(false, cell.neighbours) &&
+                pos.x >= 0 && pos.x < arena_x_max && pos.y >= 0 &&
+                pos.y < arena_y_max) {
+                f(pos);
+            }
+        });
+    }
+
+    /**
+     * Call f with every dead position in the arena with exactly three live
+     * neighbours.
+     */
+    template <typename F> void each_birth(F f) const {
+        each_birth(conway_rule, f);
+    }
+
+  private:
+    struct Cell {
+        int neighbours = 0;
+        bool alive = false;
+    };
+
+    void fold_halo(Topology topology, Position pos);
+
+    int arena_x_max;
+    int arena_y_max;
+    PositionMap<Cell> cells;
+};
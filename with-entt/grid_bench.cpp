@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <entt/entt.hpp>
+
+#include "bench.hpp"
+#include "components.hpp"
+#include "grid.hpp"
+#include "random.hpp"
+#include "systems.hpp"
+#include "thread_pool.hpp"
+
+// Seeding a board should scale linearly with its area.
+static void BM_initialise_registry(benchmark::State &state) {
+    auto dim = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        entt::registry registry;
+        RandGen rand_gen(42);
+        initialise_registry(registry, dim * dim / 4, dim, dim, rand_gen);
+
+        // Don't time tearing the registry down
+        state.PauseTiming();
+        registry = entt::registry();
+        state.ResumeTiming();
+    }
+    state.SetComplexityN(static_cast<int64_t>(dim) * dim);
+    state.SetItemsProcessed(state.iterations() * dim * dim);
+}
+BENCHMARK(BM_initialise_registry)
+    ->Arg(64)
+    ->Arg(256)
+    ->Arg(1024)
+    ->Arg(2048)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity(benchmark::oN);
+
+/**
+ * A board seeded at a density, that can be put back the way it was seeded.
+ */
+class SeededBoard {
+  public:
+    SeededBoard(int dim_, double density) : dim(dim_) {
+        seed_board(registry, dim, density);
+        registry.view<entt::tag<"is_alive"_hs>>().each(
+            [&](auto entity, auto _) { seeded.push_back(entity); });
+    }
+
+    /**
+     * Bring the board back to its seeded cells.
+     */
+    void reset() {
+        registry.view<entt::tag<"is_alive_next"_hs>>().each(
+            [&](auto entity, auto _) {
+                registry.remove<entt::tag<"is_alive_next"_hs>>(entity);
+            });
+        registry.view<entt::tag<"is_alive"_hs>>().each(
+            [&](auto entity, auto _) {
+                registry.remove<entt::tag<"is_alive"_hs>>(entity);
+            });
+        for (auto entity : seeded) {
+            registry.assign<entt::tag<"is_alive"_hs>>(entity);
+        }
+    }
+
+    entt::registry registry;
+    int dim;
+
+  private:
+    std::vector<entt::entity> seeded;
+};
+
+/**
+ * Time one call of a system at the board's seeded density. Left to run, a
+ * dense board decays to a few percent alive within a benchmark, so the board
+ * is reset before every iteration and only the system is timed, manually
+ * rather than by pausing the timer, which would cost more than the system
+ * does on the smaller boards. before runs the systems ahead of it in the
+ * generation, untimed.
+ */
+template <typename Before, typename System>
+static void time_seeded(benchmark::State &state, SeededBoard &board,
+                        Before before, System system) {
+    for (auto _ : state) {
+        board.reset();
+        before(board.registry);
+        auto start = std::chrono::steady_clock::now();
+        system(board.registry);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        state.SetIterationTime(
+            std::chrono::duration<double>(elapsed).count());
+    }
+    state.SetItemsProcessed(state.iterations() * board.dim * board.dim);
+}
+
+/**
+ * Time a system on a board seeded at the size and density of the matrix's
+ * arguments.
+ */
+template <typename Before, typename System>
+static void time_at_density(benchmark::State &state, Before before,
+                            System system) {
+    SeededBoard board(static_cast<int>(state.range(0)),
+                      state.range(1) / 100.0);
+    time_seeded(state, board, before, system);
+}
+
+static void nothing(entt::registry &) {}
+
+// The lifecycle system should scale linearly with the area of the board.
+static void BM_lifecycle_system(benchmark::State &state) {
+    auto dim = static_cast<int>(state.range(0));
+    SeededBoard board(dim, 0.3);
+    time_seeded(state, board, nothing, [](entt::registry &registry) {
+        lifecycle_system(registry);
+    });
+    state.SetComplexityN(static_cast<int64_t>(dim) * dim);
+}
+BENCHMARK(BM_lifecycle_system)
+    ->Arg(50)
+    ->Arg(128)
+    ->Arg(256)
+    ->Arg(512)
+    ->Arg(1024)
+    ->Arg(2048)
+    ->Arg(4096)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime()
+    ->Complexity(benchmark::oN);
+
+static void BM_initialise_registry_density(benchmark::State &state) {
+    auto dim = static_cast<int>(state.range(0));
+    auto n_alive_cells = static_cast<int>(dim * dim * state.range(1) / 100);
+    for (auto _ : state) {
+        entt::registry registry;
+        RandGen rand_gen(42);
+        initialise_registry(registry, n_alive_cells, dim, dim, rand_gen);
+
+        state.PauseTiming();
+        registry = entt::registry();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * dim * dim);
+}
+BENCHMARK(BM_initialise_registry_density)->Apply(size_density_matrix);
+
+static void BM_lifecycle_system_density(benchmark::State &state) {
+    time_at_density(state, nothing, [](entt::registry &registry) {
+        lifecycle_system(registry);
+    });
+}
+BENCHMARK(BM_lifecycle_system_density)
+    ->Apply(size_density_matrix)
+    ->UseManualTime();
+
+static void BM_cleanup_system(benchmark::State &state) {
+    time_at_density(
+        state,
+        [](entt::registry &registry) { lifecycle_system(registry); },
+        [](entt::registry &registry) { cleanup_system(registry); });
+}
+BENCHMARK(BM_cleanup_system)->Apply(size_density_matrix)->UseManualTime();
+
+static void BM_update_system(benchmark::State &state) {
+    time_at_density(
+        state,
+        [](entt::registry &registry) {
+            lifecycle_system(registry);
+            cleanup_system(registry);
+        },
+        [](entt::registry &registry) { update_system(registry); });
+}
+BENCHMARK(BM_update_system)->Apply(size_density_matrix)->UseManualTime();
+
+// A whole generation with the lifecycle, cleanup and update systems, to
+// compare against the fused step system below.
+static void BM_generation_systems(benchmark::State &state) {
+    auto dim = static_cast<int>(state.range(0));
+    entt::registry registry;
+    seed_board(registry, dim, 0.3);
+
+    for (auto _ : state) {
+        lifecycle_system(registry);
+        cleanup_system(registry);
+        update_system(registry);
+    }
+    state.SetItemsProcessed(state.iterations() * dim * dim);
+}
+BENCHMARK(BM_generation_systems)
+    ->Arg(256)
+    ->Arg(1024)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_step_system(benchmark::State &state) {
+    auto dim = static_cast<int>(state.range(0));
+    entt::registry registry;
+    seed_board(registry, dim, 0.3);
+
+    for (auto _ : state) {
+        step_system(registry);
+    }
+    state.SetItemsProcessed(state.iterations() * dim * dim);
+}
+BENCHMARK(BM_step_system)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+// A board of still life blocks with one blinker in the middle only has the
+// tiles around the blinker active, so the time should track those rather
+// than the area.
+static void BM_step_system_settled(benchmark::State &state) {
+    auto dim = static_cast<int>(state.range(0));
+    entt::registry registry;
+    for (auto x = 0; x < dim; x++) {
+        for (auto y = 0; y < dim; y++) {
+            auto entity = registry.create();
+            registry.assign<Position>(entity, x, y);
+            auto in_block = x % 8 < 2 && y % 8 < 2;
+            auto in_blinker = y == dim / 2 + 4 && x >= dim / 2 + 3 &&
+                              x <= dim / 2 + 5;
+            if (in_block || in_blinker) {
+                registry.assign<entt::tag<"is_alive"_hs>>(entity);
+            }
+        }
+    }
+    // The first step visits every tile
+    step_system(registry);
+
+    double active_tiles = 0;
+    for (auto _ : state) {
+        step_system(registry);
+        active_tiles += registry.ctx<LiveGrid>().active_tile_count();
+    }
+    state.counters["active_tiles"] = active_tiles / state.iterations();
+    state.counters["tiles"] = registry.ctx<LiveGrid>().tile_count();
+    state.SetItemsProcessed(state.iterations() * dim * dim);
+}
+BENCHMARK(BM_step_system_settled)
+    ->Arg(256)
+    ->Arg(1024)
+    ->Unit(benchmark::kMillisecond);
+
+// Generation time should fall with the number of threads. The speedup counter
+// is relative to the single threaded run of the same board.
+static void BM_lifecycle_system_threads(benchmark::State &state) {
+    static std::map<int64_t, double> single_threaded;
+
+    auto dim = static_cast<int>(state.range(0));
+    auto threads = static_cast<int>(state.range(1));
+    entt::registry registry;
+    seed_board(registry, dim, 0.3);
+    registry.set<ThreadPool>(threads);
+
+    double seconds = 0;
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+        lifecycle_system(registry);
+        seconds += std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+        state.PauseTiming();
+        cleanup_system(registry);
+        update_system(registry);
+        state.ResumeTiming();
+    }
+
+    auto per_generation = seconds / state.iterations();
+    if (threads == 1) {
+        single_threaded[dim] = per_generation;
+    }
+    if (single_threaded.count(dim)) {
+        state.counters["speedup"] = single_threaded[dim] / per_generation;
+    }
+    state.counters["threads"] = threads;
+}
+BENCHMARK(BM_lifecycle_system_threads)
+    ->Apply([](benchmark::internal::Benchmark *bench) {
+        auto max_threads =
+            std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        for (auto threads = 1; threads <= max_threads; threads++) {
+            bench->Args({2048, threads});
+        }
+    })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
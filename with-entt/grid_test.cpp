@@ -0,0 +1,267 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <cstddef>
+#include <random>
+#include <type_traits>
+#include <unordered_set>
+
+#include <doctest.h>
+#include <entt/entt.hpp>
+
+#include "components.hpp"
+#include "grid.hpp"
+
+// The grids are reused between generations and must never be copied per cell
+static_assert(!std::is_copy_constructible<LiveGrid>::value, "");
+static_assert(!std::is_copy_assignable<LiveGrid>::value, "");
+static_assert(!std::is_copy_constructible<SparseGrid>::value, "");
+
+TEST_SUITE("LiveGrid") {
+    TEST_CASE("live cells are found at their position") {
+        entt::registry registry;
+        auto alive = registry.create();
+        registry.assign<Position>(alive, 3, 4);
+        registry.assign<entt::tag<"is_alive"_hs>>(alive);
+        auto dead = registry.create();
+        registry.assign<Position>(dead, 4, 4);
+
+        LiveGrid grid;
+        grid.rebuild(registry);
+
+        REQUIRE(grid.at(Position(3, 4)) == alive);
+        REQUIRE(grid.at(Position(4, 4)) == entt::null);
+        REQUIRE(grid.at(Position(-100, 100)) == entt::null);
+    }
+
+    TEST_CASE("an empty registry has no neighbours anywhere") {
+        entt::registry registry;
+        LiveGrid grid;
+        grid.rebuild(registry);
+
+        REQUIRE(grid.count_neighbours(Position(0, 0)) == 0);
+        REQUIRE(grid.at(Position(0, 0)) == entt::null);
+    }
+
+    TEST_CASE("neighbour counts match a brute force count") {
+        std::random_device rand_dev;
+        std::mt19937 rand_gen(rand_dev());
+        std::uniform_int_distribution<> dist(-10, 10);
+
+        entt::registry registry;
+        std::unordered_set<Position> alive;
+        for (auto i = 0; i < 60; i++) {
+            Position pos(dist(rand_gen), dist(rand_gen));
+            if (alive.insert(pos).second) {
+                auto entity = registry.create();
+                registry.assign<Position>(entity, pos);
+                registry.assign<entt::tag<"is_alive"_hs>>(entity);
+            }
+        }
+
+        LiveGrid grid;
+        grid.rebuild(registry);
+
+        for (auto x = -15; x <= 15; x++) {
+            for (auto y = -15; y <= 15; y++) {
+                int expected = 0;
+                for (auto dx = -1; dx <= 1; dx++) {
+                    for (auto dy = -1; dy <= 1; dy++) {
+                        if ((dx != 0 || dy != 0) &&
+                            alive.count(Position(x + dx, y + dy))) {
+                            expected++;
+                        }
+                    }
+                }
+                CAPTURE(Position(x, y));
+                CHECK(grid.count_neighbours(Position(x, y)) == expected);
+            }
+        }
+    }
+
+    TEST_CASE("rebuilding forgets cells that are no longer alive") {
+        entt::registry registry;
+        auto entity = registry.create();
+        registry.assign<Position>(entity, 0, 0);
+        registry.assign<entt::tag<"is_alive"_hs>>(entity);
+
+        LiveGrid grid;
+        grid.rebuild(registry);
+        REQUIRE(grid.count_neighbours(Position(1, 1)) == 1);
+
+        registry.remove<entt::tag<"is_alive"_hs>>(entity);
+        grid.rebuild(registry);
+        REQUIRE(grid.count_neighbours(Position(1, 1)) == 0);
+        REQUIRE(grid.at(Position(0, 0)) == entt::null);
+    }
+
+    TEST_CASE("rebuilding finds cells recreated at the same count") {
+        entt::registry registry;
+        auto first = registry.create();
+        registry.assign<Position>(first, 0, 0);
+        auto second = registry.create();
+        registry.assign<Position>(second, 1, 0);
+
+        LiveGrid grid;
+        grid.rebuild(registry);
+
+        // Swap which entity is at each position, with the same number of them
+        registry.destroy(first);
+        registry.destroy(second);
+        auto left = registry.create();
+        registry.assign<Position>(left, 0, 0);
+        registry.assign<entt::tag<"is_alive"_hs>>(left);
+        auto right = registry.create();
+        registry.assign<Position>(right, 1, 0);
+        registry.assign<entt::tag<"is_alive"_hs>>(right);
+        REQUIRE_FALSE(grid.in_sync(registry));
+
+        grid.rebuild(registry);
+        REQUIRE(grid.at(Position(0, 0)) == left);
+        REQUIRE(grid.at(Position(1, 0)) == right);
+    }
+
+    TEST_CASE("rebuilding finds cells that were moved") {
+        entt::registry registry;
+        auto entity = registry.create();
+        registry.assign<Position>(entity, 0, 0);
+        registry.assign<entt::tag<"is_alive"_hs>>(entity);
+
+        LiveGrid grid;
+        grid.rebuild(registry);
+
+        registry.replace<Position>(entity, 5, 5);
+        REQUIRE_FALSE(grid.in_sync(registry));
+
+        grid.rebuild(registry);
+        REQUIRE(grid.at(Position(5, 5)) == entity);
+        REQUIRE(grid.at(Position(0, 0)) == entt::null);
+        REQUIRE(grid.count_neighbours(Position(4, 4)) == 1);
+    }
+
+    void fill(entt::registry &registry, int width, int height) {
+        for (auto x = 0; x < width; x++) {
+            for (auto y = 0; y < height; y++) {
+                auto entity = registry.create();
+                registry.assign<Position>(entity, x, y);
+            }
+        }
+    }
+
+    TEST_CASE("every tile is active after a rebuild") {
+        entt::registry registry;
+        fill(registry, 200, 100);
+
+        LiveGrid grid;
+        grid.rebuild(registry);
+        auto n_tiles = static_cast<std::size_t>(grid.tile_count());
+        REQUIRE(grid.take_active_tiles().size() == n_tiles);
+        REQUIRE(grid.active_tile_count() == n_tiles);
+        REQUIRE(grid.take_active_tiles().empty());
+    }
+
+    TEST_CASE("a change marks its tile and the tiles around it") {
+        entt::registry registry;
+        fill(registry, 200, 200);
+
+        LiveGrid grid;
+        grid.rebuild(registry);
+        grid.take_active_tiles();
+
+        SUBCASE("in the middle of a tile") {
+            grid.set_alive(Position(100, 100), true);
+            REQUIRE(grid.take_active_tiles().size() == 9);
+        }
+        SUBCASE("in a corner of the board") {
+            grid.set_alive(Position(0, 0), true);
+            REQUIRE(grid.take_active_tiles().size() == 4);
+        }
+        SUBCASE("setting a cell to its current state changes nothing") {
+            grid.set_alive(Position(100, 100), false);
+            REQUIRE(grid.take_active_tiles().empty());
+        }
+    }
+
+    TEST_CASE("the grid is in sync until the registry changes elsewhere") {
+        entt::registry registry;
+        fill(registry, 10, 10);
+        LiveGrid grid;
+        REQUIRE_FALSE(grid.in_sync(registry));
+
+        grid.rebuild(registry);
+        REQUIRE(grid.in_sync(registry));
+
+        auto entity = grid.at(Position(0, 0));
+        REQUIRE(entity == entt::null);
+        registry.view<Position>().each([&](auto entity, auto &pos) {
+            if (pos == Position(3, 3)) {
+                registry.assign<entt::tag<"is_alive"_hs>>(entity);
+            }
+        });
+        REQUIRE_FALSE(grid.in_sync(registry));
+
+        grid.set_alive(Position(3, 3), true);
+        REQUIRE(grid.in_sync(registry));
+        REQUIRE(grid.count_neighbours(Position(4, 4)) == 1);
+
+        grid.invalidate();
+        REQUIRE_FALSE(grid.in_sync(registry));
+    }
+
+    TEST_CASE("the grid sees tags moved between cells elsewhere") {
+        entt::registry registry;
+        auto from = registry.create();
+        registry.assign<Position>(from, 0, 0);
+        registry.assign<entt::tag<"is_alive"_hs>>(from);
+        auto to = registry.create();
+        registry.assign<Position>(to, 5, 5);
+
+        LiveGrid grid;
+        grid.rebuild(registry);
+        REQUIRE(grid.in_sync(registry));
+
+        // The number of live cells stays the same
+        registry.remove<entt::tag<"is_alive"_hs>>(from);
+        registry.assign<entt::tag<"is_alive"_hs>>(to);
+        REQUIRE_FALSE(grid.in_sync(registry));
+
+        grid.rebuild(registry);
+        REQUIRE(grid.in_sync(registry));
+        REQUIRE(grid.at(Position(0, 0)) == entt::null);
+        REQUIRE(grid.at(Position(5, 5)) == to);
+    }
+}
+
+TEST_SUITE("SparseGrid") {
+    TEST_CASE("neighbour counts only cover cells next to live cells") {
+        entt::registry registry;
+        for (auto x = 0; x < 3; x++) {
+            auto entity = registry.create();
+            registry.assign<Position>(entity, x, 1);
+            registry.assign<entt::tag<"is_alive"_hs>>(entity);
+        }
+
+        SparseGrid grid(10, 10);
+        grid.rebuild(registry);
+
+        REQUIRE(grid.count_neighbours(Position(1, 0)) == 3);
+        REQUIRE(grid.count_neighbours(Position(1, 1)) == 2);
+        REQUIRE(grid.count_neighbours(Position(0, 1)) == 1);
+        REQUIRE(grid.count_neighbours(Position(5, 5)) == 0);
+    }
+
+    TEST_CASE("births are limited to the arena") {
+        entt::registry registry;
+        for (auto x = 0; x < 3; x++) {
+            auto entity = registry.create();
+            registry.assign<Position>(entity, x, 0);
+            registry.assign<entt::tag<"is_alive"_hs>>(entity);
+        }
+
+        SparseGrid grid(10, 10);
+        grid.rebuild(registry);
+
+        std::unordered_set<Position> births;
+        grid.each_birth([&](Position pos) { births.insert(pos); });
+        REQUIRE(births == std::unordered_set<Position>{Position(1, 1)});
+    }
+}
@@ -0,0 +1,318 @@
+#include <cstdint>
+#include <vector>
+
+#include "hashlife.hpp"
+
+Hashlife::Hashlife(std::size_t max_nodes_)
+    : Hashlife(conway_rule, max_nodes_) {}
+
+Hashlife::Hashlife(Rule rule_, std::size_t max_nodes_)
+    : rule(rule_), max_nodes(max_nodes_), buckets(1 << 10, no_node),
+      root(dead_cell), generations(0) {
+    nodes.push_back(Node{no_node, no_node, no_node, no_node, no_node,
+                         no_node, 0, 0, 0});
+    nodes.push_back(Node{no_node, no_node, no_node, no_node, no_node,
+                         no_node, 0, 0, 1});
+    empties.push_back(dead_cell);
+    root = empty(3);
+}
+
+bool Hashlife::get(std::int64_t x, std::int64_t y) const {
+    auto half = half_width(nodes[root].level);
+    if (x < -half || x >= half || y < -half || y >= half) {
+        return false;
+    }
+    x += half;
+    y += half;
+    auto id = root;
+    while (nodes[id].level > 0 && nodes[id].population > 0) {
+        auto &node = nodes[id];
+        half = half_width(node.level);
+        if (y < half) {
+            id = x < half ? node.nw : node.ne;
+        } else {
+            id = x < half ? node.sw : node.se;
+        }
+        x %= half;
+        y %= half;
+    }
+    return id == live_cell;
+}
+
+void Hashlife::set(std::int64_t x, std::int64_t y, bool alive) {
+    grow_to(x, y);
+    auto half = half_width(nodes[root].level);
+    root = set(root, x + half, y + half, alive);
+}
+
+Hashlife::NodeId Hashlife::set(NodeId id, std::int64_t x, std::int64_t y,
+                               bool alive) {
+    auto node = nodes[id];
+    if (node.level == 0) {
+        return alive ? live_cell : dead_cell;
+    }
+    auto half = half_width(node.level);
+    if (y < half) {
+        if (x < half) {
+            node.nw = set(node.nw, x, y, alive);
+        } else {
+            node.ne = set(node.ne, x - half, y, alive);
+        }
+    } else {
+        if (x < half) {
+            node.sw = set(node.sw, x, y - half, alive);
+        } else {
+            node.se = set(node.se, x - half, y - half, alive);
+        }
+    }
+    return join(node.nw, node.ne, node.sw, node.se);
+}
+
+void Hashlife::grow_to(std::int64_t x, std::int64_t y) {
+    auto half = half_width(nodes[root].level);
+    while (x < -half || x >= half || y < -half || y >= half) {
+        root = centre(root);
+        half = half_width(nodes[root].level);
+    }
+}
+
+void Hashlife::step(std::uint64_t n_generations) {
+    for (auto k = 0; n_generations != 0; k++, n_generations >>= 1) {
+        if (!(n_generations & 1)) {
+            continue;
+        }
+        if (k <= max_jump) {
+            jump(k);
+        } else {
+            for (auto i = 0; i < 1 << (k - max_jump); i++) {
+                jump(max_jump);
+            }
+        }
+    }
+}
+
+void Hashlife::jump(int k) {
+    // Pad the board until everything alive lies in its centre quarter, so
+    // the centre half it is reduced to holds everything alive 2^k
+    // generations later
+    while (nodes[root].level < k + 2 || !is_padded(root)) {
+        root = centre(root);
+    }
+    root = successor(root, k);
+    generations += std::uint64_t(1) << k;
+    if (node_count() > max_nodes) {
+        collect_garbage();
+    }
+}
+
+std::uint64_t Hashlife::hash(NodeId nw, NodeId ne, NodeId sw, NodeId se) {
+    auto h = (std::uint64_t(nw) << 32 | ne) * 0x9e3779b97f4a7c15ULL ^
+             (std::uint64_t(sw) << 32 | se);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+Hashlife::NodeId Hashlife::join(NodeId nw, NodeId ne, NodeId sw, NodeId se) {
+    auto bucket = hash(nw, ne, sw, se) & (buckets.size() - 1);
+    for (auto id = buckets[bucket]; id != no_node; id = nodes[id].next) {
+        auto &node = nodes[id];
+        if (node.nw == nw && node.ne == ne && node.sw == sw && node.se == se) {
+            return id;
+        }
+    }
+
+    Node node{nw,
+              ne,
+              sw,
+              se,
+              no_node,
+              buckets[bucket],
+              std::uint8_t(nodes[nw].level + 1),
+              0,
+              nodes[nw].population + nodes[ne].population +
+                  nodes[sw].population + nodes[se].population};
+    NodeId id;
+    if (free_nodes.empty()) {
+        id = NodeId(nodes.size());
+        nodes.push_back(node);
+    } else {
+        id = free_nodes.back();
+        free_nodes.pop_back();
+        nodes[id] = node;
+    }
+    buckets[bucket] = id;
+    if (node_count() > buckets.size()) {
+        rehash(buckets.size() * 2);
+    }
+    return id;
+}
+
+Hashlife::NodeId Hashlife::empty(int level) {
+    while (int(empties.size()) <= level) {
+        auto below = empties.back();
+        empties.push_back(join(below, below, below, below));
+    }
+    return empties[level];
+}
+
+Hashlife::NodeId Hashlife::centre(NodeId id) {
+    auto node = nodes[id];
+    auto border = empty(node.level - 1);
+    return join(join(border, border, border, node.nw),
+                join(border, border, node.ne, border),
+                join(border, node.sw, border, border),
+                join(node.se, border, border, border));
+}
+
+bool Hashlife::is_padded(NodeId id) const {
+    auto &node = nodes[id];
+    if (node.level < 3) {
+        return false;
+    }
+    auto &nw = nodes[node.nw], &ne = nodes[node.ne];
+    auto &sw = nodes[node.sw], &se = nodes[node.se];
+    auto inner = nodes[nodes[nw.se].se].population +
+                 nodes[nodes[ne.sw].sw].population +
+                 nodes[nodes[sw.ne].ne].population +
+                 nodes[nodes[se.nw].nw].population;
+    return inner == node.population;
+}
+
+Hashlife::NodeId Hashlife::step_4x4(NodeId id) {
+    // Unpack the 4x4 square into 16 bits, row by row from the top left
+    auto &node = nodes[id];
+    std::uint32_t bits = 0;
+    NodeId quadrants[] = {node.nw, node.ne, node.sw, node.se};
+    for (auto q = 0; q < 4; q++) {
+        auto &quadrant = nodes[quadrants[q]];
+        NodeId cells[] = {quadrant.nw, quadrant.ne, quadrant.sw, quadrant.se};
+        for (auto c = 0; c < 4; c++) {
+            auto x = (q % 2) * 2 + c % 2;
+            auto y = (q / 2) * 2 + c / 2;
+            if (cells[c] == live_cell) {
+                bits |= 1u << (y * 4 + x);
+            }
+        }
+    }
+
+    NodeId next[4];
+    for (auto c = 0; c < 4; c++) {
+        auto x = 1 + c % 2;
+        auto y = 1 + c / 2;
+        auto neighbour_count = 0;
+        for (auto dy = -1; dy <= 1; dy++) {
+            for (auto dx = -1; dx <= 1; dx++) {
+                if (dx != 0 || dy != 0) {
+                    neighbour_count += (bits >> ((y + dy) * 4 + x + dx)) & 1;
+                }
+            }
+        }
+        bool alive = (bits >> (y * 4 + x)) & 1;
+        next[c] = rule.next(alive, neighbour_count) ? live_cell : dead_cell;
+    }
+    return join(next[0], next[1], next[2], next[3]);
+}
+
+Hashlife::NodeId Hashlife::successor(NodeId id, int k) {
+    auto node = nodes[id];
+    if (node.result != no_node && node.result_step == k) {
+        return node.result;
+    }
+
+    NodeId result;
+    if (node.population == 0) {
+        result = empty(node.level - 1);
+    } else if (node.level == 2) {
+        result = step_4x4(id);
+    } else {
+        auto nw = nodes[node.nw], ne = nodes[node.ne];
+        auto sw = nodes[node.sw], se = nodes[node.se];
+
+        // The nine overlapping squares half this node's width, advanced as
+        // far as they can go in one step
+        auto first = k < node.level - 2 ? k : node.level - 3;
+        NodeId parts[9] = {
+            successor(node.nw, first),
+            successor(join(nw.ne, ne.nw, nw.se, ne.sw), first),
+            successor(node.ne, first),
+            successor(join(nw.sw, nw.se, sw.nw, sw.ne), first),
+            successor(join(nw.se, ne.sw, sw.ne, se.nw), first),
+            successor(join(ne.sw, ne.se, se.nw, se.ne), first),
+            successor(node.sw, first),
+            successor(join(sw.ne, se.nw, sw.se, se.sw), first),
+            successor(node.se, first),
+        };
+
+        // Reassemble the centre, either from the parts' inner corners when
+        // they are already 2^k generations on, or by advancing the four
+        // squares they make up again
+        NodeId quarters[4];
+        for (auto q = 0; q < 4; q++) {
+            auto i = (q / 2) * 3 + q % 2;
+            auto a = parts[i], b = parts[i + 1];
+            auto c = parts[i + 3], d = parts[i + 4];
+            if (first == k) {
+                quarters[q] = join(nodes[a].se, nodes[b].sw, nodes[c].ne,
+                                   nodes[d].nw);
+            } else {
+                quarters[q] = successor(join(a, b, c, d), first);
+            }
+        }
+        result = join(quarters[0], quarters[1], quarters[2], quarters[3]);
+    }
+
+    nodes[id].result = result;
+    nodes[id].result_step = std::uint8_t(k);
+    return result;
+}
+
+void Hashlife::rehash(std::size_t n_buckets) {
+    buckets.assign(n_buckets, no_node);
+    for (NodeId id = 0; id < nodes.size(); id++) {
+        auto &node = nodes[id];
+        if (node.level == 0 || node.level == free_level) {
+            continue;
+        }
+        auto bucket = hash(node.nw, node.ne, node.sw, node.se) & (n_buckets - 1);
+        node.next = buckets[bucket];
+        buckets[bucket] = id;
+    }
+}
+
+void Hashlife::mark(NodeId id, std::vector<std::uint8_t> &marks) const {
+    if (marks[id]) {
+        return;
+    }
+    marks[id] = 1;
+    auto &node = nodes[id];
+    if (node.level > 0) {
+        mark(node.nw, marks);
+        mark(node.ne, marks);
+        mark(node.sw, marks);
+        mark(node.se, marks);
+    }
+}
+
+void Hashlife::collect_garbage() {
+    std::vector<std::uint8_t> marks(nodes.size(), 0);
+    mark(root, marks);
+    for (auto id : empties) {
+        mark(id, marks);
+    }
+    marks[live_cell] = 1;
+
+    free_nodes.clear();
+    for (NodeId id = 0; id < nodes.size(); id++) {
+        auto &node = nodes[id];
+        if (!marks[id]) {
+            node.level = free_level;
+            node.result = no_node;
+            free_nodes.push_back(id);
+        } else if (node.result != no_node && !marks[node.result]) {
+            node.result = no_node;
+        }
+    }
+    rehash(buckets.size());
+}
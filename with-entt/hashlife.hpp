@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "rule.hpp"
+
+/**
+ * Hashlife universe: an unbounded board stored as a hash-consed quadtree.
+ *
+ * Every distinct square of cells is stored once, so repeated structure costs
+ * nothing, and the result of advancing each square is memoised on it. That
+ * lets the universe jump forward 2^k generations in time roughly proportional
+ * to the number of distinct squares involved rather than to k, the area or
+ * the population.
+ *
+ * Nodes live in one flat pool and refer to each other by index. Once a jump
+ * leaves more than max_nodes nodes, the ones no longer reachable from the
+ * board are collected and their memoised results dropped. The cap is checked
+ * between jumps, so a single jump can briefly exceed it.
+ *
+ * The board is centred on the origin and x and y grow right and down. The
+ * rule is fixed for the life of the universe, as every memoised result
+ * depends on it, and must not have births with no neighbours.
+ */
+class Hashlife {
+  public:
+    typedef std::uint32_t NodeId;
+
+    explicit Hashlife(std::size_t max_nodes_ = std::size_t(1) << 22);
+    explicit Hashlife(Rule rule_,
+                      std::size_t max_nodes_ = std::size_t(1) << 22);
+    Hashlife(const Hashlife &) = delete;
+    Hashlife &operator=(const Hashlife &) = delete;
+
+    bool get(std::int64_t x, std::int64_t y) const;
+    void set(std::int64_t x, std::int64_t y, bool alive);
+
+    /**
+     * Number of live cells on the board.
+     */
+    std::uint64_t population() const { return nodes[root].population; }
+
+    /**
+     * Number of generations the board has been advanced by.
+     */
+    std::uint64_t generation() const { return generations; }
+
+    /**
+     * The largest k jump() takes. A jump of 2^k pads the board to level
+     * k + 2, and node widths only fit in 64 bits up to level 62.
+     */
+    static const int max_jump = 60;
+
+    /**
+     * Advance the board by the given number of generations, as a jump of
+     * each power of two making it up. Powers above 2^max_jump are made of
+     * several jumps of 2^max_jump.
+     */
+    void step(std::uint64_t n_generations);
+
+    /**
+     * Advance the board by 2^k generations, k at most max_jump.
+     */
+    void jump(int k);
+
+    /**
+     * Drop every node no longer reachable from the board.
+     */
+    void collect_garbage();
+
+    /**
+     * Number of nodes in use, including the ones no longer reachable until
+     * they are collected.
+     */
+    std::size_t node_count() const { return nodes.size() - free_nodes.size(); }
+
+    /**
+     * Call f with the x and y of every live cell in [x_begin, x_end) by
+     * [y_begin, y_end). Empty squares are skipped whole.
+     */
+    template <typename F>
+    void each_alive(std::int64_t x_begin, std::int64_t y_begin,
+                    std::int64_t x_end, std::int64_t y_end, F f) const {
+        auto half = half_width(nodes[root].level);
+        each_alive(root, -half, -half, x_begin, y_begin, x_end, y_end, f);
+    }
+
+  private:
+    struct Node {
+        NodeId nw, ne, sw, se;
+        // The centre of this node advanced 2^result_step generations, or
+        // no_node if it hasn't been computed
+        NodeId result;
+        // Next node in the same hash bucket
+        NodeId next;
+        std::uint8_t level;
+        std::uint8_t result_step;
+        std::uint64_t population;
+    };
+
+    static constexpr NodeId no_node = 0xffffffff;
+    static constexpr NodeId dead_cell = 0;
+    static constexpr NodeId live_cell = 1;
+    // Level of a node on the free list
+    static constexpr std::uint8_t free_level = 0xff;
+
+    static std::int64_t half_width(int level) {
+        return level == 0 ? 0 : std::int64_t(1) << (level - 1);
+    }
+
+    /**
+     * The canonical node with the given quadrants.
+     */
+    NodeId join(NodeId nw, NodeId ne, NodeId sw, NodeId se);
+    NodeId empty(int level);
+
+    /**
+     * The node one level up with this one in its centre and a dead border.
+     */
+    NodeId centre(NodeId id);
+    bool is_padded(NodeId id) const;
+
+    /**
+     * The centre half of the node advanced 2^k generations, k at most the
+     * node's level - 2.
+     */
+    NodeId successor(NodeId id, int k);
+    NodeId step_4x4(NodeId id);
+
+    NodeId set(NodeId id, std::int64_t x, std::int64_t y, bool alive);
+    void grow_to(std::int64_t x, std::int64_t y);
+    void rehash(std::size_t n_buckets);
+    void mark(NodeId id, std::vector<std::uint8_t> &marks) const;
+    static std::uint64_t hash(NodeId nw, NodeId ne, NodeId sw, NodeId se);
+
+    template <typename F>
+    void each_alive(NodeId id, std::int64_t x, std::int64_t y,
+                    std::int64_t x_begin, std::int64_t y_begin,
+                    std::int64_t x_end, std::int64_t y_end, F &f) const {
+        auto &node = nodes[id];
+        auto width = std::int64_t(1) << node.level;
+        if (node.population == 0 || x >= x_end || y >= y_end ||
+            x + width <= x_begin || y + width <= y_begin) {
+            return;
+        }
+        if (node.level == 0) {
+            f(x, y);
+            return;
+        }
+        auto half = width / 2;
+        each_alive(node.nw, x, y, x_begin, y_begin, x_end, y_end, f);
+        each_alive(node.ne, x + half, y, x_begin, y_begin, x_end, y_end, f);
+        each_alive(node.sw, x, y + half, x_begin, y_begin, x_end, y_end, f);
+        each_alive(node.se, x + half, y + half, x_begin, y_begin, x_end,
+                   y_end, f);
+    }
+
+    Rule rule;
+    std::size_t max_nodes;
+    std::vector<Node> nodes;
+    std::vector<NodeId> free_nodes;
+    std::vector<NodeId> buckets;
+    std::vector<NodeId> empties;
+    NodeId root;
+    std::uint64_t generations;
+};
@@ -0,0 +1,213 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <cstdint>
+#include <set>
+#include <type_traits>
+
+#include <doctest.h>
+
+#include "bitgrid.hpp"
+#include "components.hpp"
+#include "hashlife.hpp"
+#include "random.hpp"
+#include "rule.hpp"
+
+// The node pool is shared by the whole board and must never be copied
+static_assert(!std::is_copy_constructible<Hashlife>::value, "");
+
+std::set<Position> alive_positions(const Hashlife &life) {
+    std::set<Position> alive;
+    life.each_alive(-(1 << 20), -(1 << 20), 1 << 20, 1 << 20,
+                    [&](std::int64_t x, std::int64_t y) {
+                        alive.insert(Position(int(x), int(y)));
+                    });
+    return alive;
+}
+
+std::set<Position> alive_positions(const BitGrid &grid) {
+    std::set<Position> alive;
+    grid.each_alive([&](Position pos) { alive.insert(pos); });
+    return alive;
+}
+
+void add_glider(Hashlife &life, int x, int y) {
+    life.set(x + 1, y, true);
+    life.set(x + 2, y + 1, true);
+    life.set(x, y + 2, true);
+    life.set(x + 1, y + 2, true);
+    life.set(x + 2, y + 2, true);
+}
+
+TEST_SUITE("Hashlife") {
+    TEST_CASE("cells can be set and cleared anywhere") {
+        Hashlife life;
+        REQUIRE(life.population() == 0);
+
+        life.set(0, 0, true);
+        life.set(-5, 3, true);
+        life.set(1000000, -2000000, true);
+        REQUIRE(life.population() == 3);
+        REQUIRE(life.get(0, 0));
+        REQUIRE(life.get(-5, 3));
+        REQUIRE(life.get(1000000, -2000000));
+        REQUIRE_FALSE(life.get(1, 0));
+        REQUIRE_FALSE(life.get(std::int64_t(1) << 40, 0));
+
+        life.set(-5, 3, false);
+        REQUIRE(life.population() == 2);
+        REQUIRE_FALSE(life.get(-5, 3));
+    }
+
+    TEST_CASE("a blinker oscillates") {
+        Hashlife life;
+        for (auto x = -1; x <= 1; x++) {
+            life.set(x, 0, true);
+        }
+        std::set<Position> horizontal{{-1, 0}, {0, 0}, {1, 0}};
+        std::set<Position> vertical{{0, -1}, {0, 0}, {0, 1}};
+
+        life.step(1);
+        REQUIRE(alive_positions(life) == vertical);
+        life.step(1);
+        REQUIRE(alive_positions(life) == horizontal);
+        life.step(7);
+        REQUIRE(alive_positions(life) == vertical);
+        REQUIRE(life.generation() == 9);
+    }
+
+    TEST_CASE("a glider moves one cell diagonally every 4 generations") {
+        Hashlife life;
+        add_glider(life, 0, 0);
+        life.step(4);
+
+        std::set<Position> moved{{2, 1}, {3, 2}, {1, 3}, {2, 3}, {3, 3}};
+        REQUIRE(alive_positions(life) == moved);
+    }
+
+    TEST_CASE("a glider can be jumped far into the future") {
+        Hashlife life;
+        add_glider(life, 0, 0);
+        life.jump(40);
+
+        std::int64_t offset = std::int64_t(1) << 38;
+        REQUIRE(life.generation() == std::uint64_t(1) << 40);
+        REQUIRE(life.population() == 5);
+        REQUIRE(life.get(offset + 1, offset));
+        REQUIRE(life.get(offset + 2, offset + 1));
+        REQUIRE(life.get(offset, offset + 2));
+        REQUIRE(life.get(offset + 1, offset + 2));
+        REQUIRE(life.get(offset + 2, offset + 2));
+    }
+
+    TEST_CASE("steps beyond the largest jump are split up") {
+        Hashlife life;
+        for (auto x = -1; x <= 1; x++) {
+            life.set(x, 0, true);
+        }
+        std::set<Position> horizontal{{-1, 0}, {0, 0}, {1, 0}};
+        std::set<Position> vertical{{0, -1}, {0, 0}, {0, 1}};
+
+        life.step(std::uint64_t(1) << 63);
+        REQUIRE(life.generation() == std::uint64_t(1) << 63);
+        REQUIRE(alive_positions(life) == horizontal);
+        life.step((std::uint64_t(1) << 63) - 1);
+        REQUIRE(alive_positions(life) == vertical);
+    }
+
+    TEST_CASE("matches stepping a bit grid one generation at a time") {
+        // The soup sits in the middle of the grid, far enough from its edges
+        // that nothing reaches them in the generations compared
+        const int size = 512;
+        const int soup = 32;
+        BitGrid grid(size, size);
+        Hashlife life;
+        RandGen rand_gen(42);
+        for (auto y = (size - soup) / 2; y < (size + soup) / 2; y++) {
+            for (auto x = (size - soup) / 2; x < (size + soup) / 2; x++) {
+                if (rand_gen() % 3 == 0) {
+                    grid.set(x, y, true);
+                    life.set(x, y, true);
+                }
+            }
+        }
+
+        int generation = 0;
+        for (auto n : {1, 1, 2, 3, 8, 13, 32, 40}) {
+            life.step(n);
+            for (auto i = 0; i < n; i++) {
+                grid.step();
+                grid.swap();
+            }
+            generation += n;
+            CAPTURE(generation);
+            REQUIRE(life.generation() == std::uint64_t(generation));
+            REQUIRE(life.population() == grid.population());
+            REQUIRE(alive_positions(life) == alive_positions(grid));
+        }
+    }
+
+    TEST_CASE("other rules match stepping a bit grid") {
+        auto rule = conway_rule;
+        SUBCASE("HighLife") { rule = highlife_rule; }
+        SUBCASE("Day & Night") { rule = day_and_night_rule; }
+        SUBCASE("B36/S125") { REQUIRE(parse_rule("B36/S125", rule)); }
+        CAPTURE(rule_name(rule));
+
+        const int size = 256;
+        const int soup = 32;
+        BitGrid grid(size, size);
+        grid.set_rule(rule);
+        Hashlife life(rule);
+        RandGen rand_gen(3);
+        for (auto y = (size - soup) / 2; y < (size + soup) / 2; y++) {
+            for (auto x = (size - soup) / 2; x < (size + soup) / 2; x++) {
+                if (rand_gen() % 2 == 0) {
+                    grid.set(x, y, true);
+                    life.set(x, y, true);
+                }
+            }
+        }
+
+        for (auto n : {1, 4, 16, 32}) {
+            life.step(n);
+            for (auto i = 0; i < n; i++) {
+                grid.step();
+                grid.swap();
+            }
+            REQUIRE(alive_positions(life) == alive_positions(grid));
+        }
+    }
+
+    TEST_CASE("garbage collection keeps the board") {
+        Hashlife life;
+        RandGen rand_gen(7);
+        for (auto i = 0; i < 400; i++) {
+            life.set(int(rand_gen() % 40), int(rand_gen() % 40), true);
+        }
+        life.step(64);
+        auto before = alive_positions(life);
+        auto nodes = life.node_count();
+
+        life.collect_garbage();
+        REQUIRE(life.node_count() < nodes);
+        REQUIRE(alive_positions(life) == before);
+        REQUIRE(life.population() == before.size());
+    }
+
+    TEST_CASE("a small node cap gives the same generations") {
+        Hashlife capped(1000);
+        Hashlife uncapped;
+        RandGen rand_gen(11);
+        for (auto i = 0; i < 400; i++) {
+            auto x = int(rand_gen() % 40), y = int(rand_gen() % 40);
+            capped.set(x, y, true);
+            uncapped.set(x, y, true);
+        }
+
+        for (auto i = 0; i < 20; i++) {
+            capped.step(37);
+            uncapped.step(37);
+            REQUIRE(alive_positions(capped) == alive_positions(uncapped));
+        }
+    }
+}
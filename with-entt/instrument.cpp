@@ -0,0 +1,406 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include "instrument.hpp"
+#include "perf_counters.hpp"
+
+// Sections past this many are not recorded
+static const int max_sections = 64;
+
+static int highest_bit(std::uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanReverse64(&bit, value);
+    return static_cast<int>(bit);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+/**
+ * Add to a counter only ever written by one thread, without the cost of an
+ * atomic read-modify-write.
+ */
+static void add(std::atomic<std::uint64_t> &counter, std::uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+}
+
+LatencyHistogram::LatencyHistogram() : samples(0), sum(0), largest(0) {
+    for (auto &count : buckets) {
+        count.store(0, relaxed);
+    }
+}
+
+int LatencyHistogram::bucket(std::uint64_t value) {
+    if (value < exact_buckets) {
+        return static_cast<int>(value);
+    }
+    auto bit = highest_bit(value);
+    auto sub = static_cast<int>((value >> (bit - 3)) & (sub_buckets - 1));
+    return exact_buckets + (bit - 4) * sub_buckets + sub;
+}
+
+std::uint64_t LatencyHistogram::bucket_top(int index) {
+    if (index < exact_buckets) {
+        return static_cast<std::uint64_t>(index);
+    }
+    auto bit = 4 + (index - exact_buckets) / sub_buckets;
+    auto sub = static_cast<std::uint64_t>((index - exact_buckets) %
+                                          sub_buckets);
+    auto width = std::uint64_t(1) << (bit - 3);
+    return (sub_buckets + sub) * width + width - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t nanoseconds) {
+    add(buckets[bucket(nanoseconds)], 1);
+    add(samples, 1);
+    add(sum, nanoseconds);
+    if (nanoseconds > largest.load(relaxed)) {
+        largest.store(nanoseconds, relaxed);
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+    for (auto i = 0; i < n_buckets; i++) {
+        add(buckets[i], other.buckets[i].load(relaxed));
+    }
+    add(samples, other.count());
+    add(sum, other.total());
+    largest.store(std::max(max(), other.max()), relaxed);
+}
+
+std::uint64_t LatencyHistogram::percentile(double fraction) const {
+    auto n_samples = count();
+    if (n_samples == 0) {
+        return 0;
+    }
+    auto rank = std::max<std::uint64_t>(
+        1, static_cast<std::uint64_t>(std::ceil(fraction * n_samples)));
+    std::uint64_t seen = 0;
+    for (auto i = 0; i < n_buckets; i++) {
+        seen += buckets[i].load(relaxed);
+        if (seen >= rank) {
+            return std::min(bucket_top(i), max());
+        }
+    }
+    return max();
+}
+
+namespace {
+
+/**
+ * What one thread has recorded of a section: its latencies and the total of
+ * each event counted in the calls that counted them.
+ */
+struct SectionStats {
+    SectionStats();
+
+    void merge(const SectionStats &other);
+
+    LatencyHistogram latency;
+    std::atomic<std::uint64_t> n_counted;
+    std::array<std::atomic<std::uint64_t>, n_perf_events> events;
+};
+
+/**
+ * The sections one thread has recorded into, and its counters once it
+ * counts events.
+ */
+struct ThreadInstruments {
+    ThreadInstruments();
+    ~ThreadInstruments();
+
+    std::array<std::atomic<SectionStats *>, max_sections> sections;
+    std::unique_ptr<PerfCounters> counters;
+};
+
+/**
+ * Every section and thread, and the samples of threads that have exited.
+ */
+struct Instruments {
+    std::mutex mutex;
+    std::array<const char *, max_sections> names{};
+    int n_sections = 0;
+    std::vector<ThreadInstruments *> threads;
+    std::array<std::unique_ptr<SectionStats>, max_sections> exited;
+    std::array<bool, n_perf_events> events_counted{};
+};
+
+} // namespace
+
+static std::atomic<bool> counting_events(false);
+static std::atomic<std::uint64_t> cell_count(0);
+static std::atomic<int> thread_count(1);
+
+SectionStats::SectionStats() : n_counted(0) {
+    for (auto &total : events) {
+        total.store(0, std::memory_order_relaxed);
+    }
+}
+
+void SectionStats::merge(const SectionStats &other) {
+    latency.merge(other.latency);
+    add(n_counted, other.n_counted.load(std::memory_order_relaxed));
+    for (auto i = 0; i < n_perf_events; i++) {
+        add(events[i], other.events[i].load(std::memory_order_relaxed));
+    }
+}
+
+static Instruments &instruments() {
+    static Instruments all;
+    return all;
+}
+
+ThreadInstruments::ThreadInstruments() {
+    for (auto &stats : sections) {
+        stats.store(nullptr, std::memory_order_relaxed);
+    }
+    auto &all = instruments();
+    std::lock_guard<std::mutex> lock(all.mutex);
+    all.threads.push_back(this);
+}
+
+ThreadInstruments::~ThreadInstruments() {
+    auto &all = instruments();
+    std::lock_guard<std::mutex> lock(all.mutex);
+    all.threads.erase(
+        std::find(all.threads.begin(), all.threads.end(), this));
+    for (auto i = 0; i < max_sections; i++) {
+        std::unique_ptr<SectionStats> stats(
+            sections[i].load(std::memory_order_relaxed));
+        if (stats) {
+            if (!all.exited[i]) {
+                all.exited[i].reset(new SectionStats());
+            }
+            all.exited[i]->merge(*stats);
+        }
+    }
+}
+
+static ThreadInstruments &this_thread_instruments() {
+    thread_local ThreadInstruments thread_instruments;
+    return thread_instruments;
+}
+
+InstrumentSection::InstrumentSection(const char *name_)
+    : section_name(name_) {
+    auto &all = instruments();
+    std::lock_guard<std::mutex> lock(all.mutex);
+    section_index = all.n_sections < max_sections ? all.n_sections++ : -1;
+    if (section_index >= 0) {
+        all.names[section_index] = section_name;
+    }
+}
+
+void instrument_record(const InstrumentSection &section,
+                       std::uint64_t nanoseconds,
+                       const PerfReading *events_start) {
+    auto &thread_instruments = this_thread_instruments();
+    auto index = section.index();
+    if (index < 0) {
+        return;
+    }
+    auto &slot = thread_instruments.sections[index];
+    auto stats = slot.load(std::memory_order_relaxed);
+    if (!stats) {
+        stats = new SectionStats();
+        slot.store(stats, std::memory_order_release);
+    }
+    stats->latency.record(nanoseconds);
+
+    PerfReading events_end;
+    if (events_start && thread_instruments.counters &&
+        thread_instruments.counters->read(events_end)) {
+        auto counts = perf_difference(*events_start, events_end);
+        add(stats->n_counted, 1);
+        for (auto i = 0; i < n_perf_events; i++) {
+            add(stats->events[i], counts[i]);
+        }
+    }
+}
+
+bool instrument_count_events() {
+    PerfCounters probe;
+    if (!probe.available()) {
+        return false;
+    }
+    auto &all = instruments();
+    {
+        std::lock_guard<std::mutex> lock(all.mutex);
+        for (auto i = 0; i < n_perf_events; i++) {
+            all.events_counted[i] = probe.counts(static_cast<PerfEvent>(i));
+        }
+    }
+    counting_events.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+bool instrument_read_events(PerfReading &reading) {
+    if (!counting_events.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    // Counters only count the thread that opened them
+    auto &counters = this_thread_instruments().counters;
+    if (!counters) {
+        counters.reset(new PerfCounters());
+    }
+    return counters->read(reading);
+}
+
+void instrument_set_cell_count(std::uint64_t n_cells) {
+    cell_count.store(n_cells, std::memory_order_relaxed);
+}
+
+void instrument_set_thread_count(int n_threads) {
+    thread_count.store(n_threads, std::memory_order_relaxed);
+}
+
+/**
+ * Write the mean of each event counted per call of each section, divided
+ * again by per_call, such as the cells each call processes.
+ */
+static void
+report_events(std::ostream &out, const Instruments &all,
+              const std::vector<std::unique_ptr<SectionStats>> &merged,
+              const char *title, double per_call) {
+    auto precision = out.precision();
+    out << std::left << std::setw(24) << title << std::right;
+    for (auto i = 0; i < n_perf_events; i++) {
+        out << std::setw(15) << perf_event_name(static_cast<PerfEvent>(i));
+        if (i == perf_instructions) {
+            out << std::setw(7) << "IPC";
+        }
+    }
+    out << "\n";
+    for (auto i = 0; i < all.n_sections; i++) {
+        auto &stats = *merged[i];
+        auto n_counted = stats.n_counted.load(std::memory_order_relaxed);
+        if (n_counted == 0) {
+            continue;
+        }
+        auto mean = [&](int event) {
+            return stats.events[event].load(std::memory_order_relaxed) /
+                   static_cast<double>(n_counted) / per_call;
+        };
+        out << std::left << std::setw(24) << all.names[i] << std::right;
+        for (auto event = 0; event < n_perf_events; event++) {
+            out << std::setw(15);
+            if (all.events_counted[event]) {
+                out << mean(event);
+            } else {
+                out << "-";
+            }
+            if (event != perf_instructions) {
+                continue;
+            }
+            out << std::setw(7);
+            if (all.events_counted[perf_instructions] &&
+                mean(perf_cycles) > 0) {
+                out << std::setprecision(2)
+                    << mean(perf_instructions) / mean(perf_cycles)
+                    << std::setprecision(precision);
+            } else {
+                out << "-";
+            }
+        }
+        out << "\n";
+    }
+}
+
+void instrument_report(std::ostream &out) {
+    auto &all = instruments();
+    std::lock_guard<std::mutex> lock(all.mutex);
+
+    std::vector<std::unique_ptr<SectionStats>> merged(all.n_sections);
+    for (auto i = 0; i < all.n_sections; i++) {
+        merged[i].reset(new SectionStats());
+        if (all.exited[i]) {
+            merged[i]->merge(*all.exited[i]);
+        }
+        for (auto thread : all.threads) {
+            auto stats = thread->sections[i].load(std::memory_order_acquire);
+            if (stats) {
+                merged[i]->merge(*stats);
+            }
+        }
+    }
+    if (std::none_of(merged.begin(), merged.end(), [](auto &stats) {
+            return stats->latency.count() > 0;
+        })) {
+        return;
+    }
+
+    auto micros = [](std::uint64_t nanoseconds) { return nanoseconds / 1e3; };
+    auto flags = out.flags();
+    auto precision = out.precision();
+    out << std::left << std::setw(24) << "section" << std::right
+        << std::setw(10) << "calls" << std::setw(12) << "p50 us"
+        << std::setw(12) << "p99 us" << std::setw(12) << "max us"
+        << std::setw(12) << "total s" << "\n";
+    out << std::fixed << std::setprecision(1);
+    for (auto i = 0; i < all.n_sections; i++) {
+        auto &histogram = merged[i]->latency;
+        if (histogram.count() == 0) {
+            continue;
+        }
+        out << std::left << std::setw(24) << all.names[i] << std::right
+            << std::setw(10) << histogram.count() << std::setw(12)
+            << micros(histogram.percentile(0.5)) << std::setw(12)
+            << micros(histogram.percentile(0.99)) << std::setw(12)
+            << micros(histogram.max()) << std::setw(12) << std::setprecision(3)
+            << histogram.total() / 1e9 << std::setprecision(1) << "\n";
+    }
+
+    if (std::any_of(merged.begin(), merged.end(), [](auto &stats) {
+            return stats->n_counted.load(std::memory_order_relaxed) > 0;
+        })) {
+        out << std::setprecision(0);
+        report_events(out, all, merged, "events per call", 1);
+        auto n_cells = cell_count.load(std::memory_order_relaxed);
+        if (n_cells > 0) {
+            out << std::setprecision(3);
+            report_events(out, all, merged, "events per cell",
+                          static_cast<double>(n_cells));
+        }
+        auto n_threads = thread_count.load(std::memory_order_relaxed);
+        if (n_threads > 1) {
+            out << "Events are only counted on the thread running each "
+                   "section, not on the "
+                << n_threads - 1
+                << " other threads it shares work with, run with -t 1 to "
+                   "count all of it\n";
+        }
+    }
+    out.flush();
+    out.flags(flags);
+    out.precision(precision);
+}
+
+static volatile std::sig_atomic_t report_requested = 0;
+
+#if defined(SIGUSR1)
+static void request_report(int) { report_requested = 1; }
+#endif
+
+void instrument_report_on_signal() {
+#if defined(SIGUSR1)
+    std::signal(SIGUSR1, request_report);
+#endif
+}
+
+void instrument_poll(std::ostream &out) {
+    if (report_requested) {
+        report_requested = 0;
+        instrument_report(out);
+    }
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#include "perf_counters.hpp"
+
+/**
+ * A histogram of latencies in nanoseconds.
+ *
+ * Buckets are exact below 16ns and then split each power of two into 8, so
+ * any percentile read back is within 12.5% of the true value, from a fixed
+ * 4KB of counts. A histogram is written by a single thread and can be read
+ * by others while it is.
+ */
+class LatencyHistogram {
+  public:
+    LatencyHistogram();
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    void record(std::uint64_t nanoseconds);
+
+    /**
+     * Add the samples of another histogram to this one.
+     */
+    void merge(const LatencyHistogram &other);
+
+    std::uint64_t count() const { return samples.load(relaxed); }
+    std::uint64_t total() const { return sum.load(relaxed); }
+    std::uint64_t max() const { return largest.load(relaxed); }
+
+    /**
+     * The latency the given fraction of samples are at or below, rounded up
+     * to the top of its bucket, or 0 if there are no samples.
+     */
+    std::uint64_t percentile(double fraction) const;
+
+  private:
+    static constexpr std::memory_order relaxed = std::memory_order_relaxed;
+    static constexpr int exact_buckets = 16;
+    static constexpr int sub_buckets = 8;
+    static constexpr int n_buckets = exact_buckets + (64 - 4) * sub_buckets;
+
+    static int bucket(std::uint64_t value);
+    static std::uint64_t bucket_top(int index);
+
+    std::array<std::atomic<std::uint64_t>, n_buckets> buckets;
+    std::atomic<std::uint64_t> samples;
+    std::atomic<std::uint64_t> sum;
+    std::atomic<std::uint64_t> largest;
+};
+
+/**
+ * A named region of code whose latency is recorded, declared once at each
+ * place it is timed by GOL_TIME.
+ */
+class InstrumentSection {
+  public:
+    explicit InstrumentSection(const char *name_);
+
+    const char *name() const { return section_name; }
+    int index() const { return section_index; }
+
+  private:
+    const char *section_name;
+    int section_index;
+};
+
+/**
+ * Record time spent in a section into the calling thread's histogram for
+ * it, and the events counted since events_start if it isn't null. Only the
+ * first use of a section on each thread takes a lock.
+ */
+void instrument_record(const InstrumentSection &section,
+                       std::uint64_t nanoseconds,
+                       const PerfReading *events_start = nullptr);
+
+/**
+ * Count hardware events in every timed section from now on, as well as
+ * timing it. Returns false, and counts nothing, if this machine has no
+ * counters we are allowed to read.
+ */
+bool instrument_count_events();
+
+/**
+ * Read the calling thread's counters, if events are being counted.
+ */
+bool instrument_read_events(PerfReading &reading);
+
+/**
+ * The number of cells in the arena, to report events per cell as well as
+ * per call.
+ */
+void instrument_set_cell_count(std::uint64_t n_cells);
+
+/**
+ * The number of threads sections share their work out between. Events are
+ * only counted on the thread that runs a section, so with more than one the
+ * report notes that the rest of the work isn't counted.
+ */
+void instrument_set_thread_count(int n_threads);
+
+/**
+ * Records the time from its construction to its destruction in a section,
+ * and the hardware events counted in it if that is turned on.
+ */
+class ScopedTimer {
+  public:
+    explicit ScopedTimer(const InstrumentSection &section_)
+        : section(section_), counting(instrument_read_events(events_start)),
+          start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        instrument_record(
+            section,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                .count(),
+            counting ? &events_start : nullptr);
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+  private:
+    const InstrumentSection &section;
+    PerfReading events_start;
+    bool counting;
+    std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * Write the calls, p50, p99, max and total latency of every section timed
+ * so far, across all threads, and the mean events counted per call and per
+ * cell if they were. Writes nothing if nothing has been timed.
+ */
+void instrument_report(std::ostream &out);
+
+/**
+ * Have SIGUSR1 ask for a report, on platforms that have it.
+ */
+void instrument_report_on_signal();
+
+/**
+ * Write a report if one has been asked for since the last call. Cheap
+ * enough to call every round.
+ */
+void instrument_poll(std::ostream &out);
+
+#define GOL_INSTRUMENT_JOIN_(a, b) a##b
+#define GOL_INSTRUMENT_JOIN(a, b) GOL_INSTRUMENT_JOIN_(a, b)
+
+/**
+ * Time the rest of the enclosing scope as the named section.
+ */
+#ifdef GOL_NO_INSTRUMENT
+#define GOL_TIME(name)                                                         \
+    do {                                                                       \
+    } while (0)
+#else
+#define GOL_TIME(name)                                                         \
+    static const InstrumentSection GOL_INSTRUMENT_JOIN(gol_section_,           \
+                                                       __LINE__)(name);        \
+    ScopedTimer GOL_INSTRUMENT_JOIN(gol_timer_, __LINE__)(                     \
+        GOL_INSTRUMENT_JOIN(gol_section_, __LINE__))
+#endif
@@ -0,0 +1,154 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+// The test targets build with timing compiled out; this one tests it
+#undef GOL_NO_INSTRUMENT
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <doctest.h>
+
+#include "instrument.hpp"
+
+TEST_SUITE("LatencyHistogram") {
+    TEST_CASE("an empty histogram reads zero") {
+        LatencyHistogram histogram;
+        REQUIRE(histogram.count() == 0);
+        REQUIRE(histogram.total() == 0);
+        REQUIRE(histogram.max() == 0);
+        REQUIRE(histogram.percentile(0.5) == 0);
+    }
+
+    TEST_CASE("small latencies are recorded exactly") {
+        LatencyHistogram histogram;
+        for (std::uint64_t ns = 1; ns <= 10; ns++) {
+            histogram.record(ns);
+        }
+        REQUIRE(histogram.count() == 10);
+        REQUIRE(histogram.total() == 55);
+        REQUIRE(histogram.max() == 10);
+        REQUIRE(histogram.percentile(0.5) == 5);
+        REQUIRE(histogram.percentile(1.0) == 10);
+    }
+
+    TEST_CASE("percentiles are within an eighth of the true value") {
+        LatencyHistogram histogram;
+        for (std::uint64_t ns = 1; ns <= 100000; ns++) {
+            histogram.record(ns * 10);
+        }
+        auto p50 = static_cast<double>(histogram.percentile(0.5));
+        auto p99 = static_cast<double>(histogram.percentile(0.99));
+        REQUIRE(p50 >= 500000);
+        REQUIRE(p50 <= 500000 * 1.125);
+        REQUIRE(p99 >= 990000);
+        REQUIRE(p99 <= 990000 * 1.125);
+        REQUIRE(histogram.percentile(1.0) == 1000000);
+    }
+
+    TEST_CASE("merging adds the other histogram's samples") {
+        LatencyHistogram histogram, other;
+        histogram.record(100);
+        other.record(300);
+        other.record(5000);
+
+        histogram.merge(other);
+        REQUIRE(histogram.count() == 3);
+        REQUIRE(histogram.total() == 5400);
+        REQUIRE(histogram.max() == 5000);
+        REQUIRE(other.count() == 2);
+    }
+}
+
+TEST_SUITE("instrument_report") {
+    TEST_CASE("sections are reported across threads") {
+        static const InstrumentSection section("test section");
+        std::thread worker([&] {
+            for (auto i = 0; i < 3; i++) {
+                ScopedTimer timer(section);
+            }
+        });
+        worker.join();
+        {
+            GOL_TIME("test macro");
+        }
+        {
+            ScopedTimer timer(section);
+        }
+
+        std::ostringstream out;
+        instrument_report(out);
+        auto report = out.str();
+        REQUIRE(report.find("p99 us") != std::string::npos);
+
+        std::istringstream lines(report);
+        std::string line;
+        auto calls = [&](const std::string &name) {
+            lines.clear();
+            lines.seekg(0);
+            while (std::getline(lines, line)) {
+                if (line.compare(0, name.size(), name) == 0) {
+                    std::istringstream fields(line.substr(name.size()));
+                    int n;
+                    fields >> n;
+                    return n;
+                }
+            }
+            return 0;
+        };
+        REQUIRE(calls("test section") == 4);
+        REQUIRE(calls("test macro") == 1);
+    }
+
+    TEST_CASE("sections that were never timed are left out") {
+        static const InstrumentSection section("never timed");
+        std::ostringstream out;
+        instrument_report(out);
+        REQUIRE(out.str().find("never timed") == std::string::npos);
+    }
+
+    TEST_CASE("polling writes nothing unless a report was asked for") {
+        std::ostringstream out;
+        instrument_poll(out);
+        REQUIRE(out.str().empty());
+    }
+}
+
+TEST_SUITE("counting events") {
+    TEST_CASE("events are reported only when they could be counted") {
+        auto counting = instrument_count_events();
+        instrument_set_cell_count(100);
+        {
+            GOL_TIME("counted section");
+            volatile int sum = 0;
+            for (auto i = 0; i < 1000; i++) {
+                sum = sum + i;
+            }
+        }
+
+        std::ostringstream out;
+        instrument_report(out);
+        auto report = out.str();
+        REQUIRE(report.find("counted section") != std::string::npos);
+        auto per_call = report.find("events per call");
+        auto per_cell = report.find("events per cell");
+        if (counting) {
+            REQUIRE(per_call != std::string::npos);
+            REQUIRE(per_cell != std::string::npos);
+            REQUIRE(report.find("LLC misses") != std::string::npos);
+            REQUIRE(report.find("only counted") == std::string::npos);
+
+            // Work shared with other threads isn't counted
+            instrument_set_thread_count(4);
+            std::ostringstream shared;
+            instrument_report(shared);
+            instrument_set_thread_count(1);
+            REQUIRE(shared.str().find("not on the 3 other threads") !=
+                    std::string::npos);
+        } else {
+            REQUIRE(per_call == std::string::npos);
+            REQUIRE(per_cell == std::string::npos);
+        }
+    }
+}
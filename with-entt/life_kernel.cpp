@@ -0,0 +1,102 @@
+#include <cstdint>
+#include <vector>
+
+#include "life_kernel.hpp"
+#include "life_kernel_impl.hpp"
+
+#ifdef GOL_KERNEL_X86
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Built with AVX2 enabled in life_kernel_avx2.cpp
+RowKernel avx2_row_kernel(Rule rule);
+
+namespace {
+
+/**
+ * Two words of cells at a time. SSE2 is part of the x86-64 baseline so needs
+ * no runtime check.
+ */
+struct Sse2Ops {
+    typedef __m128i V;
+    static const int lanes = 2;
+
+    static V splat(Word w) { return _mm_set1_epi64x(w); }
+    static V load(const Word *p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    }
+    static void store(Word *p, V v) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+    }
+    static V bit_and(V a, V b) { return _mm_and_si128(a, b); }
+    static V bit_or(V a, V b) { return _mm_or_si128(a, b); }
+    static V bit_xor(V a, V b) { return _mm_xor_si128(a, b); }
+    static V and_not(V a, V b) { return _mm_andnot_si128(a, b); }
+    template <int N> static V shift_left(V v) { return _mm_slli_epi64(v, N); }
+    template <int N> static V shift_right(V v) {
+        return _mm_srli_epi64(v, N);
+    }
+};
+
+} // namespace
+
+static bool cpu_has_avx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool os_saves_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+                        (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return os_saves_avx && (info[1] & (1 << 5));
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+RowKernel row_kernel(KernelIsa isa, Rule rule) {
+    switch (isa) {
+    case KernelIsa::scalar:
+        return rule_row_kernel<ScalarOps>(rule);
+#ifdef GOL_KERNEL_X86
+    case KernelIsa::sse2:
+        return rule_row_kernel<Sse2Ops>(rule);
+    case KernelIsa::avx2:
+        return avx2_row_kernel(rule);
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+std::vector<KernelIsa> available_kernel_isas() {
+    std::vector<KernelIsa> isas = {KernelIsa::scalar};
+#ifdef GOL_KERNEL_X86
+    isas.push_back(KernelIsa::sse2);
+    if (cpu_has_avx2()) {
+        isas.push_back(KernelIsa::avx2);
+    }
+#endif
+    return isas;
+}
+
+KernelIsa best_kernel_isa() { return available_kernel_isas().back(); }
+
+const char *kernel_isa_name(KernelIsa isa) {
+    switch (isa) {
+    case KernelIsa::scalar:
+        return "scalar";
+    case KernelIsa::sse2:
+        return "sse2";
+    case KernelIsa::avx2:
+        return "avx2";
+    }
+    return "unknown";
+}
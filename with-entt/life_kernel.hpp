@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "rule.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GOL_KERNEL_X86
+#endif
+
+/**
+ * Computes the next generation for a row of a bit-packed board, from the row
+ * and the rows above and below it. Each row must have a readable word before
+ * and after its n_words words, holding the cells beyond its edges. Kernels
+ * specialised for a rule ignore the one passed in.
+ */
+typedef void (*RowKernel)(const std::uint64_t *above, const std::uint64_t *row,
+                          const std::uint64_t *below, std::uint64_t *out,
+                          int n_words, Rule rule);
+
+/**
+ * The instruction sets a row kernel can be built for.
+ */
+enum class KernelIsa { scalar, sse2, avx2 };
+
+/**
+ * The row kernel for the given instruction set and rule, or nullptr if it
+ * isn't compiled in. Common rules have kernels specialised for them, others
+ * get a kernel that looks the rule up.
+ */
+RowKernel row_kernel(KernelIsa isa, Rule rule = conway_rule);
+
+/**
+ * The instruction sets the current CPU can run a kernel for.
+ */
+std::vector<KernelIsa> available_kernel_isas();
+
+/**
+ * The fastest instruction set the current CPU can run a kernel for.
+ */
+KernelIsa best_kernel_isa();
+
+const char *kernel_isa_name(KernelIsa isa);
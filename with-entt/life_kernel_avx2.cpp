@@ -0,0 +1,42 @@
+// Compiled with AVX2 enabled. Nothing in here may run before the CPU has been
+// checked for AVX2 support.
+
+#include "life_kernel.hpp"
+
+#ifdef GOL_KERNEL_X86
+#include <immintrin.h>
+
+#include "life_kernel_impl.hpp"
+
+namespace {
+
+/**
+ * Four words of cells at a time.
+ */
+struct Avx2Ops {
+    typedef __m256i V;
+    static const int lanes = 4;
+
+    static V splat(Word w) { return _mm256_set1_epi64x(w); }
+    static V load(const Word *p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    }
+    static void store(Word *p, V v) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+    }
+    static V bit_and(V a, V b) { return _mm256_and_si256(a, b); }
+    static V bit_or(V a, V b) { return _mm256_or_si256(a, b); }
+    static V bit_xor(V a, V b) { return _mm256_xor_si256(a, b); }
+    static V and_not(V a, V b) { return _mm256_andnot_si256(a, b); }
+    template <int N> static V shift_left(V v) {
+        return _mm256_slli_epi64(v, N);
+    }
+    template <int N> static V shift_right(V v) {
+        return _mm256_srli_epi64(v, N);
+    }
+};
+
+} // namespace
+
+RowKernel avx2_row_kernel(Rule rule) { return rule_row_kernel<Avx2Ops>(rule); }
+#endif
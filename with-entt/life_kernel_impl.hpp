@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstdint>
+
+#include "life_kernel.hpp"
+#include "rule.hpp"
+
+// Everything here has internal linkage. The header is compiled with different
+// instruction sets enabled in different translation units, and the linker
+// must not swap one copy for another.
+namespace {
+
+typedef std::uint64_t Word;
+
+/**
+ * One 64-bit word of cells at a time.
+ */
+struct ScalarOps {
+    typedef Word V;
+    static const int lanes = 1;
+
+    static V splat(Word w) { return w; }
+    static V load(const Word *p) { return *p; }
+    static void store(Word *p, V v) { *p = v; }
+    static V bit_and(V a, V b) { return a & b; }
+    static V bit_or(V a, V b) { return a | b; }
+    static V bit_xor(V a, V b) { return a ^ b; }
+    // ~a & b
+    static V and_not(V a, V b) { return ~a & b; }
+    template <int N> static V shift_left(V v) { return v << N; }
+    template <int N> static V shift_right(V v) { return v >> N; }
+};
+
+/**
+ * Sum three one bit values, giving a two bit result.
+ */
+template <typename Ops>
+inline void add3(typename Ops::V a, typename Ops::V b, typename Ops::V c,
+                 typename Ops::V &sum, typename Ops::V &carry) {
+    auto partial = Ops::bit_xor(a, b);
+    sum = Ops::bit_xor(partial, c);
+    carry = Ops::bit_or(Ops::bit_and(a, b), Ops::bit_and(partial, c));
+}
+
+// Shift the neighbouring columns over each cell, pulling in the edge bit of
+// the adjacent word.
+template <typename Ops> inline typename Ops::V west(const Word *r) {
+    return Ops::bit_or(Ops::template shift_left<1>(Ops::load(r)),
+                       Ops::template shift_right<63>(Ops::load(r - 1)));
+}
+
+template <typename Ops> inline typename Ops::V east(const Word *r) {
+    return Ops::bit_or(Ops::template shift_right<1>(Ops::load(r)),
+                       Ops::template shift_left<63>(Ops::load(r + 1)));
+}
+
+/**
+ * Cells with exactly n neighbours, from the bits of their neighbour counts.
+ */
+template <typename Ops>
+inline typename Ops::V count_is(const typename Ops::V (&bits)[4], int n) {
+    auto present = Ops::splat(~Word(0)), absent = Ops::splat(0);
+    for (auto b = 0; b < 4; b++) {
+        if ((n >> b) & 1) {
+            present = Ops::bit_and(present, bits[b]);
+        } else {
+            absent = Ops::bit_or(absent, bits[b]);
+        }
+    }
+    return Ops::and_not(absent, present);
+}
+
+/**
+ * Apply a rule fixed at compile time, adding a term for each neighbour count
+ * it has a birth or survival for from n up.
+ */
+template <typename Ops, std::uint32_t Mask, int N = 0>
+inline typename Ops::V next_cells(FixedRule<Mask> rule,
+                                  const typename Ops::V (&bits)[4],
+                                  typename Ops::V alive) {
+    if constexpr (Mask == conway_rule.mask && N == 0) {
+        // Alive next with 3 neighbours, or 2 neighbours if alive now
+        auto three_or_alive = Ops::bit_or(bits[0], alive);
+        return Ops::and_not(
+            bits[3],
+            Ops::and_not(bits[2], Ops::bit_and(bits[1], three_or_alive)));
+    } else if constexpr (N > 8) {
+        return Ops::splat(0);
+    } else {
+        constexpr bool born = (Mask >> N) & 1;
+        constexpr bool survives = (Mask >> (N + 16)) & 1;
+        auto rest = next_cells<Ops, Mask, N + 1>(rule, bits, alive);
+        if constexpr (born && survives) {
+            return Ops::bit_or(rest, count_is<Ops>(bits, N));
+        } else if constexpr (born) {
+            return Ops::bit_or(rest,
+                               Ops::and_not(alive, count_is<Ops>(bits, N)));
+        } else if constexpr (survives) {
+            return Ops::bit_or(rest,
+                               Ops::bit_and(alive, count_is<Ops>(bits, N)));
+        } else {
+            return rest;
+        }
+    }
+}
+
+/**
+ * Apply any rule, looking up the birth and survival of each neighbour count
+ * in its mask.
+ */
+template <typename Ops>
+inline typename Ops::V next_cells(Rule rule, const typename Ops::V (&bits)[4],
+                                  typename Ops::V alive) {
+    auto next = Ops::splat(0);
+    for (auto n = 0; n <= 8; n++) {
+        Word born = (rule.mask >> n) & 1;
+        Word survives = (rule.mask >> (n + 16)) & 1;
+        if (born || survives) {
+            auto lives = Ops::bit_or(Ops::bit_and(alive, Ops::splat(-survives)),
+                                     Ops::and_not(alive, Ops::splat(-born)));
+            next = Ops::bit_or(next,
+                               Ops::bit_and(lives, count_is<Ops>(bits, n)));
+        }
+    }
+    return next;
+}
+
+/**
+ * Apply the rule to Ops::lanes words of cells starting at word i.
+ */
+template <typename Ops, typename RuleT>
+inline void step_words(const Word *above, const Word *row, const Word *below,
+                       Word *out, int i, RuleT rule) {
+    typename Ops::V above_sum, above_carry, below_sum, below_carry;
+    add3<Ops>(west<Ops>(above + i), Ops::load(above + i),
+              east<Ops>(above + i), above_sum, above_carry);
+    add3<Ops>(west<Ops>(below + i), Ops::load(below + i),
+              east<Ops>(below + i), below_sum, below_carry);
+    auto row_west = west<Ops>(row + i), row_east = east<Ops>(row + i);
+    auto row_sum = Ops::bit_xor(row_west, row_east);
+    auto row_carry = Ops::bit_and(row_west, row_east);
+
+    // Add up the columns of the per row sums, bit0 to bit3 of the neighbour
+    // count.
+    typename Ops::V bit0, ones_carry, twos, fours;
+    add3<Ops>(above_sum, below_sum, row_sum, bit0, ones_carry);
+    add3<Ops>(above_carry, below_carry, row_carry, twos, fours);
+    auto bit1 = Ops::bit_xor(twos, ones_carry);
+    auto twos_carry = Ops::bit_and(twos, ones_carry);
+    auto bit2 = Ops::bit_xor(fours, twos_carry);
+    auto bit3 = Ops::bit_and(fours, twos_carry);
+
+    const typename Ops::V bits[4] = {bit0, bit1, bit2, bit3};
+    Ops::store(out + i, next_cells<Ops>(rule, bits, Ops::load(row + i)));
+}
+
+/**
+ * The rule a kernel steps with, fixed ones ignore the rule passed in.
+ */
+template <typename RuleT> inline RuleT kernel_rule(Rule) { return RuleT(); }
+template <> inline Rule kernel_rule<Rule>(Rule rule) { return rule; }
+
+/**
+ * Step a whole row, Ops::lanes words at a time with a scalar tail.
+ */
+template <typename Ops, typename RuleT>
+void step_row(const Word *above, const Word *row, const Word *below, Word *out,
+              int n_words, Rule rule) {
+    auto step_rule = kernel_rule<RuleT>(rule);
+    int i = 0;
+    for (; i + Ops::lanes <= n_words; i += Ops::lanes) {
+        step_words<Ops>(above, row, below, out, i, step_rule);
+    }
+    for (; i < n_words; i++) {
+        step_words<ScalarOps>(above, row, below, out, i, step_rule);
+    }
+}
+
+/**
+ * The kernel stepping with the rule, specialised for it if it is a common
+ * rule.
+ */
+template <typename Ops> RowKernel rule_row_kernel(Rule rule) {
+    return with_rule(rule, [](auto step_rule) -> RowKernel {
+        return &step_row<Ops, decltype(step_rule)>;
+    });
+}
+
+} // namespace
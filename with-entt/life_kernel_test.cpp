@@ -0,0 +1,124 @@
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <rapidcheck.h>
+#include <rapidcheck/gtest.h>
+
+#include "life_kernel.hpp"
+#include "rule.hpp"
+
+typedef std::vector<std::uint64_t> Row;
+
+/**
+ * A random row of n_words words with a dead word either side of it.
+ */
+Row padded_row(int n_words) {
+    auto row = *rc::gen::container<Row>(n_words,
+                                        rc::gen::arbitrary<std::uint64_t>());
+    row.insert(row.begin(), 0);
+    row.push_back(0);
+    return row;
+}
+
+bool cell(const Row &row, int x) {
+    if (x < 0 || x >= static_cast<int>(row.size() - 2) * 64) {
+        return false;
+    }
+    return (row[1 + x / 64] >> (x % 64)) & 1;
+}
+
+/**
+ * The rule applied to a single cell by counting its neighbours one by one.
+ */
+bool scalar_rule(const Row &above, const Row &row, const Row &below, int x,
+                 Rule rule = conway_rule) {
+    int neighbour_count = 0;
+    for (auto dx = -1; dx <= 1; dx++) {
+        neighbour_count += cell(above, x + dx) + cell(below, x + dx);
+        if (dx != 0) {
+            neighbour_count += cell(row, x + dx);
+        }
+    }
+    bool alive = cell(row, x);
+    return ((alive ? rule.survival() : rule.birth()) >> neighbour_count) & 1;
+}
+
+RC_GTEST_PROP(row_kernel, matches_the_scalar_rule_cell_for_cell, ()) {
+    auto n_words = *rc::gen::inRange(1, 20);
+    auto above = padded_row(n_words);
+    auto row = padded_row(n_words);
+    auto below = padded_row(n_words);
+
+    for (auto isa : available_kernel_isas()) {
+        RC_TAG(kernel_isa_name(isa));
+        Row out(n_words + 2, 0);
+        row_kernel(isa)(&above[1], &row[1], &below[1], &out[1], n_words,
+                        conway_rule);
+
+        for (auto x = 0; x < n_words * 64; x++) {
+            RC_ASSERT(cell(out, x) == scalar_rule(above, row, below, x));
+        }
+        RC_ASSERT(out.front() == 0u);
+        RC_ASSERT(out.back() == 0u);
+    }
+}
+
+RC_GTEST_PROP(row_kernel, sparse_rows_match_the_scalar_rule, ()) {
+    // Random words are half alive, so also check boards sparse enough to
+    // have births and survivals
+    auto n_words = *rc::gen::inRange(1, 20);
+    auto sparse_row = [&] {
+        auto row = padded_row(n_words);
+        auto mask = padded_row(n_words);
+        auto mask2 = padded_row(n_words);
+        for (std::size_t i = 0; i < row.size(); i++) {
+            row[i] &= mask[i] & mask2[i];
+        }
+        return row;
+    };
+    auto above = sparse_row(), row = sparse_row(), below = sparse_row();
+
+    for (auto isa : available_kernel_isas()) {
+        Row out(n_words + 2, 0);
+        row_kernel(isa)(&above[1], &row[1], &below[1], &out[1], n_words,
+                        conway_rule);
+
+        for (auto x = 0; x < n_words * 64; x++) {
+            RC_ASSERT(cell(out, x) == scalar_rule(above, row, below, x));
+        }
+    }
+}
+
+RC_GTEST_PROP(row_kernel, every_rule_matches_the_scalar_rule, ()) {
+    // The common rules have their own kernels, any other rule is looked up
+    auto rule = *rc::gen::element(
+        conway_rule, highlife_rule, seeds_rule, day_and_night_rule,
+        Rule(*rc::gen::inRange<std::uint16_t>(0, 1 << 9) & ~1,
+             *rc::gen::inRange<std::uint16_t>(0, 1 << 9)));
+    RC_TAG(rule_name(rule));
+    auto n_words = *rc::gen::inRange(1, 20);
+    auto above = padded_row(n_words);
+    auto row = padded_row(n_words);
+    auto below = padded_row(n_words);
+
+    for (auto isa : available_kernel_isas()) {
+        Row out(n_words + 2, 0);
+        row_kernel(isa, rule)(&above[1], &row[1], &below[1], &out[1], n_words,
+                              rule);
+
+        for (auto x = 0; x < n_words * 64; x++) {
+            RC_ASSERT(cell(out, x) == scalar_rule(above, row, below, x, rule));
+        }
+    }
+}
+
+TEST(row_kernel, scalar_kernel_is_always_available) {
+    auto isas = available_kernel_isas();
+    ASSERT_FALSE(isas.empty());
+    EXPECT_EQ(isas.front(), KernelIsa::scalar);
+    EXPECT_EQ(isas.back(), best_kernel_isa());
+    for (auto isa : isas) {
+        EXPECT_NE(row_kernel(isa), nullptr);
+    }
+}
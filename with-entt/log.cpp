@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+#include "log.hpp"
+
+// How long the writer sleeps once the ring is empty. Flushing and stopping
+// wake it straight away.
+static const std::chrono::milliseconds writer_idle(10);
+
+/**
+ * Copy only the used part of a record's text.
+ */
+static void copy(const LogRecord &from, LogRecord &to) {
+    to.truncated = from.truncated;
+    to.size = from.size;
+    std::memcpy(to.text.data(), from.text.data(), from.size);
+}
+
+LogRing::LogRing() : head(0), tail(0) {
+    for (std::size_t i = 0; i < capacity; i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool LogRing::push(const LogRecord &record) {
+    auto position = tail.load(std::memory_order_relaxed);
+    while (true) {
+        auto &slot = slots[position % capacity];
+        auto sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence == position) {
+            // Free this lap; claim it unless another producer got there first
+            if (tail.compare_exchange_weak(position, position + 1,
+                                           std::memory_order_relaxed)) {
+                copy(record, slot.record);
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (sequence < position) {
+            // Still holding a record from the last lap
+            return false;
+        } else {
+            position = tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool LogRing::pop(LogRecord &record) {
+    auto position = head.load(std::memory_order_relaxed);
+    auto &slot = slots[position % capacity];
+    if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+        return false;
+    }
+    copy(slot.record, record);
+    head.store(position + 1, std::memory_order_relaxed);
+    slot.sequence.store(position + capacity, std::memory_order_release);
+    return true;
+}
+
+Logger::Logger(std::ostream &out_)
+    : out(out_), n_dropped(0), n_dropped_reported(0), flush_requested(0),
+      flushed(0), stopping(false), thread([this] { work(); }) {}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    thread.join();
+}
+
+bool Logger::log(const LogRecord &record) {
+    if (!ring.push(record)) {
+        n_dropped.fetch_add(1, relaxed);
+        return false;
+    }
+    return true;
+}
+
+void Logger::flush() {
+    // Counting claimed rather than finished pushes also covers records
+    // queued behind one another thread is still copying in
+    auto target = ring.claimed();
+    std::unique_lock<std::mutex> lock(mutex);
+    flush_requested = std::max(flush_requested, target);
+    wake.notify_all();
+    written.wait(lock, [&] { return flushed >= target; });
+}
+
+void Logger::write(const LogRecord &record) {
+    out.write(record.text.data(), record.size);
+    if (record.truncated) {
+        out << "...";
+    }
+    out << '\n';
+}
+
+/**
+ * Write records until the ring is empty and at least the first until have
+ * been written, waiting for any of those still being pushed.
+ */
+void Logger::drain(std::size_t until) {
+    LogRecord record;
+    while (true) {
+        if (ring.pop(record)) {
+            write(record);
+        } else if (ring.popped() < until) {
+            // Claimed by a push that hasn't finished copying it in
+            std::this_thread::yield();
+        } else {
+            return;
+        }
+    }
+}
+
+void Logger::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        auto was_stopping = stopping;
+        auto until = was_stopping ? ring.claimed() : flush_requested;
+        lock.unlock();
+
+        auto start = ring.popped();
+        drain(until);
+        auto dropped = n_dropped.load(relaxed);
+        auto wrote = ring.popped() != start;
+        if (dropped != n_dropped_reported) {
+            out << "Dropped " << dropped - n_dropped_reported
+                << " log lines, the log was full\n";
+            n_dropped_reported = dropped;
+            wrote = true;
+        }
+        if (wrote) {
+            out.flush();
+        }
+
+        lock.lock();
+        flushed = std::max(flushed, until);
+        written.notify_all();
+        // Anything logged before stopping was asked for has been written
+        if (was_stopping) {
+            return;
+        }
+        wake.wait_for(lock, writer_idle, [this] {
+            return stopping || flush_requested > flushed;
+        });
+    }
+}
+
+Logger &logger() {
+    static Logger instance(std::cerr);
+    return instance;
+}
+
+LogLine::LogLine() : std::ostream(this) {}
+
+LogLine &LogLine::begin(LogLevel level, const char *file, int line) {
+    thread_local LogLine log_line;
+    auto &text = log_line.current.text;
+    log_line.setp(text.data(), text.data() + text.size());
+    log_line.current.truncated = false;
+    log_line.clear();
+
+    log_line << file << ":" << line << ": ";
+    if (level == LogLevel::debug) {
+        log_line << "debug: ";
+    } else if (level == LogLevel::warning) {
+        log_line << "warning: ";
+    } else if (level == LogLevel::error) {
+        log_line << "error: ";
+    }
+    return log_line;
+}
+
+const LogRecord &LogLine::record() {
+    current.size = static_cast<std::uint16_t>(pptr() - pbase());
+    return current;
+}
+
+void LogLine::commit() { logger().log(record()); }
+
+int LogLine::overflow(int) {
+    current.truncated = true;
+    return std::streambuf::traits_type::eof();
+}
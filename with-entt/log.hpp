@@ -1,10 +1,212 @@
-#include <iostream>
+#pragma once
 
-#ifdef GOL_NO_LOG
-#define LOG(msg) do{}while(0)
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+
+enum class LogLevel : std::uint8_t {
+    debug = 0,
+    info = 1,
+    warning = 2,
+    error = 3,
+};
+
+/**
+ * One formatted log line, as queued for the writer.
+ */
+struct LogRecord {
+    static const std::size_t max_text = 244;
+
+    bool truncated = false;
+    std::uint16_t size = 0;
+    std::array<char, max_text> text;
+};
+
+/**
+ * Bounded lock-free queue of log records, written by any number of threads
+ * and read by one.
+ *
+ * Each slot carries a sequence number saying whether it is free to write or
+ * ready to read in the current lap around the ring, so a push or pop is one
+ * compare and swap on its own index and never waits on the other side. A
+ * push into a full ring fails rather than blocking.
+ */
+class LogRing {
+  public:
+    static const std::size_t capacity = 1024;
+
+    LogRing();
+    LogRing(const LogRing &) = delete;
+    LogRing &operator=(const LogRing &) = delete;
+
+    bool push(const LogRecord &record);
+    bool pop(LogRecord &record);
+
+    /**
+     * Number of records pushes have claimed slots for so far, whether or not
+     * they have finished copying them in.
+     */
+    std::size_t claimed() const { return tail.load(std::memory_order_acquire); }
+
+    /**
+     * Number of records popped so far. Only for the reading thread.
+     */
+    std::size_t popped() const { return head.load(std::memory_order_relaxed); }
+
+  private:
+    struct alignas(64) Slot {
+        std::atomic<std::size_t> sequence;
+        LogRecord record;
+    };
+
+    std::array<Slot, capacity> slots;
+    alignas(64) std::atomic<std::size_t> head;
+    alignas(64) std::atomic<std::size_t> tail;
+};
+
+/**
+ * Writes queued log records to a stream from a background thread.
+ *
+ * Logging never blocks the caller on I/O: a record is copied into the ring
+ * and the writer drains it in batches. Records logged while the ring is full
+ * are dropped and counted, and the count is written in their place. Whatever
+ * is queued is written before the logger is destroyed.
+ */
+class Logger {
+  public:
+    explicit Logger(std::ostream &out_);
+    ~Logger();
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    /**
+     * Queue a record, returning false if it was dropped.
+     */
+    bool log(const LogRecord &record);
+
+    /**
+     * Wait until everything logged so far, and the count of any lines
+     * dropped, has been written.
+     */
+    void flush();
+
+    std::uint64_t dropped() const { return n_dropped.load(relaxed); }
+
+  private:
+    static constexpr std::memory_order relaxed = std::memory_order_relaxed;
+
+    void work();
+    void drain(std::size_t until);
+    void write(const LogRecord &record);
+
+    std::ostream &out;
+    LogRing ring;
+    std::atomic<std::uint64_t> n_dropped;
+    std::uint64_t n_dropped_reported;
+
+    // Guards the writer's sleeping and the flush positions, never taken by
+    // log(). Flushes ask for the ring to be written up to flush_requested
+    // and the writer acknowledges in flushed once it has been.
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable written;
+    std::size_t flush_requested;
+    std::size_t flushed;
+    bool stopping;
+    std::thread thread;
+};
+
+/**
+ * The logger LOG writes to, writing to stderr.
+ */
+Logger &logger();
+
+/**
+ * Formats one log line straight into a record, without allocating.
+ * Anything past the end of the record is cut off.
+ */
+class LogLine : private std::streambuf, public std::ostream {
+  public:
+    /**
+     * The calling thread's line, cleared and started with the source
+     * location.
+     */
+    static LogLine &begin(LogLevel level, const char *file, int line);
+
+    /**
+     * Hand the line to the logger.
+     */
+    void commit();
+
+    /**
+     * The line formatted so far.
+     */
+    const LogRecord &record();
+
+  private:
+    LogLine();
+
+    int overflow(int c) override;
+
+    LogRecord current;
+};
+
+#ifndef GOL_LOG_LEVEL
+#define GOL_LOG_LEVEL 1
+#endif
+
+#define GOL_LOG_AT(level, msg)                                                 \
+    do {                                                                       \
+        auto &gol_log_line = LogLine::begin(level, __FILE__, __LINE__);        \
+        gol_log_line << msg;                                                   \
+        gol_log_line.commit();                                                 \
+    } while (0)
+
+// Levels below GOL_LOG_LEVEL, and every level under GOL_NO_LOG, are compiled
+// out along with the formatting of their messages
+#if defined(GOL_NO_LOG) || GOL_LOG_LEVEL > 0
+#define LOG_DEBUG(msg)                                                         \
+    do {                                                                       \
+    } while (0)
 #else
+#define LOG_DEBUG(msg) GOL_LOG_AT(LogLevel::debug, msg)
+#endif
+#if defined(GOL_NO_LOG) || GOL_LOG_LEVEL > 1
 #define LOG(msg)                                                               \
     do {                                                                       \
-        std::cerr << __FILE__ << ":" << __LINE__ << ": " << msg << std::endl;  \
     } while (0)
+#else
+#define LOG(msg) GOL_LOG_AT(LogLevel::info, msg)
+#endif
+#if defined(GOL_NO_LOG) || GOL_LOG_LEVEL > 2
+#define LOG_WARNING(msg)                                                       \
+    do {                                                                       \
+    } while (0)
+#else
+#define LOG_WARNING(msg) GOL_LOG_AT(LogLevel::warning, msg)
+#endif
+#if defined(GOL_NO_LOG) || GOL_LOG_LEVEL > 3
+#define LOG_ERROR(msg)                                                         \
+    do {                                                                       \
+    } while (0)
+#else
+#define LOG_ERROR(msg) GOL_LOG_AT(LogLevel::error, msg)
+#endif
+
+/**
+ * Wait for everything logged so far to be written, such as before writing
+ * to stderr directly.
+ */
+#ifdef GOL_NO_LOG
+#define LOG_FLUSH()                                                            \
+    do {                                                                       \
+    } while (0)
+#else
+#define LOG_FLUSH() logger().flush()
 #endif
@@ -0,0 +1,32 @@
+#include <cstdint>
+#include <ostream>
+
+#include <benchmark/benchmark.h>
+
+#include "log.hpp"
+
+// What a LOG costs the calling thread before the record is queued.
+static void BM_log_line(benchmark::State &state) {
+    std::int64_t generation = 0;
+    for (auto _ : state) {
+        auto &line = LogLine::begin(LogLevel::info, __FILE__, __LINE__);
+        line << "Stepping " << generation++ << " of " << 4096 << " tiles";
+        benchmark::DoNotOptimize(line.record().size);
+    }
+}
+BENCHMARK(BM_log_line);
+
+// Queueing a record from several threads at once, with the writer draining
+// them into a stream that discards them. Records that find the ring full are
+// dropped, which is as cheap as queueing them.
+static void BM_logger_log(benchmark::State &state) {
+    static std::ostream discard(nullptr);
+    static Logger logger(discard);
+    auto &line = LogLine::begin(LogLevel::info, __FILE__, __LINE__);
+    line << "Stepping " << 1024 << " of " << 4096 << " tiles";
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(logger.log(line.record()));
+    }
+}
+BENCHMARK(BM_logger_log)->Threads(1)->Threads(4);
@@ -0,0 +1,205 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <doctest.h>
+
+#include "log.hpp"
+
+static LogRecord make_record(const std::string &text) {
+    LogRecord record;
+    record.size = static_cast<std::uint16_t>(text.size());
+    text.copy(record.text.data(), text.size());
+    return record;
+}
+
+static std::string text(const LogRecord &record) {
+    return std::string(record.text.data(), record.size);
+}
+
+TEST_SUITE("LogRing") {
+    TEST_CASE("records come out in the order they went in") {
+        LogRing ring;
+        LogRecord record;
+        REQUIRE_FALSE(ring.pop(record));
+
+        REQUIRE(ring.push(make_record("one")));
+        REQUIRE(ring.push(make_record("two")));
+        REQUIRE(ring.pop(record));
+        REQUIRE(text(record) == "one");
+        REQUIRE(ring.pop(record));
+        REQUIRE(text(record) == "two");
+        REQUIRE_FALSE(ring.pop(record));
+    }
+
+    TEST_CASE("a full ring drops records until one is read") {
+        LogRing ring;
+        for (std::size_t i = 0; i < LogRing::capacity; i++) {
+            REQUIRE(ring.push(make_record(std::to_string(i))));
+        }
+        REQUIRE_FALSE(ring.push(make_record("dropped")));
+
+        LogRecord record;
+        REQUIRE(ring.pop(record));
+        REQUIRE(text(record) == "0");
+        REQUIRE(ring.push(make_record("last")));
+        for (std::size_t i = 1; i < LogRing::capacity; i++) {
+            REQUIRE(ring.pop(record));
+        }
+        REQUIRE(ring.pop(record));
+        REQUIRE(text(record) == "last");
+        REQUIRE_FALSE(ring.pop(record));
+    }
+
+    TEST_CASE("claimed and popped count the records through the ring") {
+        LogRing ring;
+        REQUIRE(ring.claimed() == 0);
+        REQUIRE(ring.push(make_record("one")));
+        REQUIRE(ring.push(make_record("two")));
+        REQUIRE(ring.claimed() == 2);
+        REQUIRE(ring.popped() == 0);
+
+        LogRecord record;
+        REQUIRE(ring.pop(record));
+        REQUIRE(ring.popped() == 1);
+        REQUIRE(ring.pop(record));
+        REQUIRE_FALSE(ring.pop(record));
+        REQUIRE(ring.popped() == 2);
+    }
+
+    TEST_CASE("records from many threads all arrive once") {
+        LogRing ring;
+        const int n_threads = 4, per_thread = 5000;
+        std::vector<std::thread> threads;
+        for (auto t = 0; t < n_threads; t++) {
+            threads.emplace_back([&ring, t] {
+                for (auto i = 0; i < per_thread; i++) {
+                    auto record =
+                        make_record(std::to_string(t * per_thread + i));
+                    while (!ring.push(record)) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        std::set<std::string> seen;
+        LogRecord record;
+        while (seen.size() < std::size_t(n_threads * per_thread)) {
+            if (ring.pop(record)) {
+                REQUIRE(seen.insert(text(record)).second);
+            }
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        REQUIRE_FALSE(ring.pop(record));
+    }
+}
+
+TEST_SUITE("Logger") {
+    TEST_CASE("flushing writes every line logged so far") {
+        std::ostringstream out;
+        Logger logger(out);
+        REQUIRE(logger.log(make_record("first")));
+        REQUIRE(logger.log(make_record("second")));
+        logger.flush();
+        REQUIRE(out.str() == "first\nsecond\n");
+        REQUIRE(logger.dropped() == 0);
+    }
+
+    TEST_CASE("lines still queued are written when the logger goes") {
+        std::ostringstream out;
+        {
+            Logger logger(out);
+            for (auto i = 0; i < 100; i++) {
+                logger.log(make_record("line"));
+            }
+        }
+        std::istringstream lines(out.str());
+        std::string line;
+        auto n_lines = 0;
+        while (std::getline(lines, line)) {
+            REQUIRE(line == "line");
+            n_lines++;
+        }
+        REQUIRE(n_lines == 100);
+    }
+
+    TEST_CASE("dropped lines are counted and reported") {
+        std::ostringstream out;
+        Logger logger(out);
+        auto n_logged = 0;
+        for (std::size_t i = 0; i < 4 * LogRing::capacity; i++) {
+            n_logged += logger.log(make_record("line"));
+        }
+        logger.flush();
+        REQUIRE(logger.dropped() == 4 * LogRing::capacity - n_logged);
+        if (logger.dropped() > 0) {
+            REQUIRE(out.str().find("Dropped") != std::string::npos);
+        }
+    }
+
+    TEST_CASE("flushing from many threads writes every line") {
+        std::ostringstream out;
+        std::atomic<int> n_logged(0);
+        {
+            Logger logger(out);
+            std::vector<std::thread> threads;
+            for (auto t = 0; t < 4; t++) {
+                threads.emplace_back([&] {
+                    for (auto i = 0; i < 200; i++) {
+                        n_logged += logger.log(make_record("line"));
+                        if (i % 20 == 0) {
+                            logger.flush();
+                        }
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            logger.flush();
+            REQUIRE(logger.dropped() == std::uint64_t(4 * 200 - n_logged));
+        }
+        auto n_lines = 0;
+        std::istringstream lines(out.str());
+        std::string line;
+        while (std::getline(lines, line)) {
+            n_lines += line == "line";
+        }
+        REQUIRE(n_lines == n_logged);
+    }
+}
+
+TEST_SUITE("LogLine") {
+    TEST_CASE("a line starts with where it was logged from") {
+        auto &line = LogLine::begin(LogLevel::info, "file.cpp", 12);
+        line << "Round " << 3;
+        REQUIRE(text(line.record()) == "file.cpp:12: Round 3");
+        REQUIRE_FALSE(line.record().truncated);
+
+        auto &warning = LogLine::begin(LogLevel::warning, "file.cpp", 13);
+        warning << "Slow";
+        REQUIRE(text(warning.record()) == "file.cpp:13: warning: Slow");
+    }
+
+    TEST_CASE("long lines are cut off at the end of the record") {
+        auto &line = LogLine::begin(LogLevel::info, "file.cpp", 12);
+        line << std::string(1000, 'x') << 42;
+        REQUIRE(line.record().size == LogRecord::max_text);
+        REQUIRE(line.record().truncated);
+
+        auto &next = LogLine::begin(LogLevel::info, "file.cpp", 14);
+        next << "short";
+        REQUIRE(text(next.record()) == "file.cpp:14: short");
+        REQUIRE_FALSE(next.record().truncated);
+    }
+}
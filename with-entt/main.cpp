@@ -1,8 +1,13 @@
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <SFML/Graphics.hpp>
@@ -10,10 +15,21 @@
 #include <SFML/System/Clock.hpp>
 #include <entt/entt.hpp>
 
+#include "backends.hpp"
+#include "bitgrid.hpp"
+#include "checkpoint.hpp"
 #include "components.hpp"
+#include "hashlife.hpp"
+#include "instrument.hpp"
 #include "log.hpp"
+#include "pattern.hpp"
+#include "random.hpp"
+#include "renderer.hpp"
+#include "rule.hpp"
+#include "snapshot.hpp"
 #include "systems.hpp"
-#include "utils.hpp"
+#include "thread_pool.hpp"
+#include "topology.hpp"
 
 struct Config {
     int arena_max_x;
@@ -21,29 +37,97 @@ struct Config {
     int scale;
     int init_cell_count;
     int max_rounds;
+    int threads;
+    std::uint64_t seed;
+    std::uint64_t jump;
+    Rule rule;
+    bool rule_given;
+    Topology topology;
+    bool topology_given;
+    std::string pattern;
+    std::string checkpoint;
+    std::uint64_t checkpoint_every;
+    std::string restore;
+    std::uint64_t first_generation;
+    std::string backend;
+    bool headless;
+    bool pipelined;
+    bool perf;
     bool help;
 
     Config()
         : arena_max_x(50), arena_max_y(50), scale(10), init_cell_count(1500),
-          max_rounds(-1), help(false) {}
+          max_rounds(-1), threads(1), seed(random_seed()), jump(1),
+          rule(conway_rule), rule_given(false), topology(Topology::dead),
+          topology_given(false), checkpoint_every(1000),
+          first_generation(0), backend("ecs"), headless(false),
+          pipelined(false), perf(false), help(false) {}
 };
 
 void parse_args(int argc, char *argv[], Config &cfg) {
-    for (auto i = 0; i < argc; i += 2) {
+    for (auto i = 0; i < argc; i++) {
         std::string arg(argv[i]);
         if (arg == "-h") {
             cfg.help = true;
             return;
+        } else if (arg == "--headless") {
+            cfg.headless = true;
+        } else if (arg == "--pipelined") {
+            cfg.pipelined = true;
+        } else if (arg == "--perf") {
+            cfg.perf = true;
+        } else if (i + 1 >= argc) {
+            // Every other option takes a value
+            cfg.help = true;
+            return;
         } else if (arg == "-x") {
-            cfg.arena_max_x = atoi(argv[i + 1]);
+            cfg.arena_max_x = atoi(argv[++i]);
         } else if (arg == "-y") {
-            cfg.arena_max_y = atoi(argv[i + 1]);
+            cfg.arena_max_y = atoi(argv[++i]);
+        } else if (arg == "-t") {
+            cfg.threads = atoi(argv[++i]);
         } else if (arg == "-s") {
-            cfg.scale = atoi(argv[i + 1]);
+            cfg.scale = atoi(argv[++i]);
         } else if (arg == "-i") {
-            cfg.init_cell_count = atoi(argv[i + 1]);
+            cfg.init_cell_count = atoi(argv[++i]);
         } else if (arg == "-m") {
-            cfg.max_rounds = atoi(argv[i + 1]);
+            cfg.max_rounds = atoi(argv[++i]);
+        } else if (arg == "-r") {
+            cfg.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-b") {
+            cfg.backend = argv[++i];
+        } else if (arg == "--rule") {
+            if (!parse_rule(argv[++i], cfg.rule)) {
+                cfg.help = true;
+                return;
+            }
+            cfg.rule_given = true;
+        } else if (arg == "--topology") {
+            if (!parse_topology(argv[++i], cfg.topology)) {
+                cfg.help = true;
+                return;
+            }
+            cfg.topology_given = true;
+        } else if (arg == "-p") {
+            cfg.pattern = argv[++i];
+        } else if (arg == "--checkpoint") {
+            cfg.checkpoint = argv[++i];
+        } else if (arg == "--checkpoint-every") {
+            cfg.checkpoint_every = std::strtoull(argv[++i], nullptr, 10);
+            if (cfg.checkpoint_every == 0) {
+                cfg.help = true;
+                return;
+            }
+        } else if (arg == "--restore") {
+            cfg.restore = argv[++i];
+        } else if (arg == "--jump") {
+            cfg.jump = std::strtoull(argv[++i], nullptr, 10);
+            if (cfg.jump == 0) {
+                cfg.help = true;
+                return;
+            }
+        } else {
+            i++;
         }
     }
 }
@@ -54,93 +138,506 @@ void usage(char *name) {
         << "-h   - Help message" << std::endl
         << "-x X - X dimension for the arena (default 50)" << std::endl
         << "-y Y - Y dimension for the arena (default 50)" << std::endl
+        << "-t T - Threads to run the lifecycle on, 0 for all cores (default 1)"
+        << std::endl
         << "-s S - Scale at which to draw the simulation (default 10)"
         << std::endl
         << "-i I - Number of cells to start the simulation with (default 1500)"
         << std::endl
         << "-m M - Max number of rounds to run for (default fovever)"
+        << std::endl
+        << "-r R - Seed for the starting cells (default random)" << std::endl
+        << "-p P - Pattern to start from instead of random cells, a .rle, .cells"
+        << " or Life 1.06 file" << std::endl
+        << "-b B - Simulation backend, ecs, sparse, bitgrid or hashlife"
+        << " (default ecs)" << std::endl
+        << "--jump N - Generations to advance each round (default 1)"
+        << std::endl
+        << "--rule R - Life-like rule in B/S notation, such as B36/S23"
+        << " (default the pattern's rule or B3/S23)" << std::endl
+        << "--topology T - How the arena's edges meet, dead, torus or klein"
+        << " (default dead or the checkpoint's)" << std::endl
+        << "--checkpoint P - Save a checkpoint to the file P as the run goes"
+        << " and when it ends" << std::endl
+        << "--checkpoint-every K - Generations between checkpoints (default"
+        << " 1000)" << std::endl
+        << "--restore P - Resume from the checkpoint in the file P, instead of"
+        << " -p or random cells" << std::endl
+        << "--headless - Run without a window for M rounds (default 1000) and"
+        << " print the throughput" << std::endl
+        << "--pipelined - Compute the next generations while rendering"
+        << std::endl
+        << "--perf - Count cycles, instructions, cache and branch misses in"
+        << " each system, on the thread running it only, so use with -t 1"
         << std::endl;
     ;
 }
 
-int main(int argc, char *argv[]) {
-    Config config;
-    parse_args(argc - 1, argv + 1, config);
-    if (config.help) {
-        usage(argv[0]);
-        std::exit(1);
+/**
+ * Handle the window's pending events.
+ */
+void poll_events(sf::RenderWindow &window) {
+    sf::Event e;
+    while (window.pollEvent(e)) {
+        switch (e.type) {
+        case sf::Event::Closed:
+            window.close();
+            break;
+        default:
+            break;
+        }
     }
+}
 
-    entt::registry registry;
+/**
+ * Advance the world by the given number of generations, one at a time.
+ */
+template <typename World> void advance(World &world, std::uint64_t n) {
+    for (std::uint64_t i = 0; i < n; i++) {
+        step_system(world);
+    }
+}
+
+/**
+ * Hashlife jumps straight there instead.
+ */
+void advance(Hashlife &life, std::uint64_t n) { step_system(life, n); }
+
+/**
+ * Saves checkpoints of the world as it runs, if asked to, every
+ * config.checkpoint_every generations and once more at the end.
+ *
+ * Only copying the live cells is done on the thread stepping the world, the
+ * file is written by a CheckpointWriter in the background. A checkpoint
+ * that comes due while the last one is still being written is put off until
+ * the writer is free, rather than stalling the loop.
+ */
+class Checkpointer {
+  public:
+    explicit Checkpointer(const Config &config_)
+        : config(config_), generation(config_.first_generation), due(false) {
+        if (!config.checkpoint.empty()) {
+            writer.reset(new CheckpointWriter(config.checkpoint));
+        }
+    }
+
+    /**
+     * Count the generations the world has just been advanced by, taking a
+     * checkpoint if one is due.
+     */
+    template <typename World> void advanced(World &world) {
+        auto previous = generation;
+        generation += config.jump;
+        if (!writer) {
+            return;
+        }
+        if (generation / config.checkpoint_every !=
+            previous / config.checkpoint_every) {
+            due = true;
+            if (!writer->ready()) {
+                LOG("Checkpoint put off, the last one is still being written");
+            }
+        }
+        if (due && writer->ready()) {
+            take(world);
+        }
+    }
+
+    /**
+     * Take a checkpoint of where the world got to and wait for it to be
+     * written.
+     */
+    template <typename World> void finish(World &world) {
+        if (!writer) {
+            return;
+        }
+        writer->wait();
+        take(world);
+        writer->wait();
+        LOG("Saved " << writer->written() << " checkpoints to "
+                     << config.checkpoint << ", up to generation "
+                     << generation);
+        if (writer->failed() > 0) {
+            LOG_FLUSH();
+            std::cerr << "Couldn't save " << writer->failed()
+                      << " checkpoints to " << config.checkpoint
+                      << std::endl;
+        }
+    }
+
+  private:
+    template <typename World> void take(World &world) {
+        GOL_TIME("checkpoint");
+        auto &checkpoint = writer->checkpoint();
+        checkpoint.width = config.arena_max_x;
+        checkpoint.height = config.arena_max_y;
+        checkpoint.rule = config.rule;
+        checkpoint.topology = config.topology;
+        snapshot_system(world, checkpoint.snapshot);
+        checkpoint.snapshot.generation = static_cast<std::int64_t>(generation);
+        writer->write();
+        due = false;
+    }
+
+    const Config &config;
+    std::uint64_t generation;
+    bool due;
+    std::unique_ptr<CheckpointWriter> writer;
+};
+
+/**
+ * Run the simulation loop over the given world until it dies out, the window
+ * is closed or the max number of rounds is reached.
+ */
+template <typename World> int simulate(const Config &config, World &world) {
     sf::VideoMode mode = sf::VideoMode(config.arena_max_x, config.arena_max_y);
     sf::RenderWindow window(mode, "Game of Life");
+    CellRenderer renderer(config.arena_max_x, config.arena_max_y, config.scale);
+    Checkpointer checkpoints(config);
     sf::Clock clock;
-    sf::Clock system_timing;
-    sf::Clock round_timing;
 
     window.clear(sf::Color::Black);
 
-    LOG("Starting the game of life");
+    render_system(window, renderer, world);
+    int rounds = 0;
+    while (window.isOpen()) {
+        GOL_TIME("round");
+        rounds++;
+        poll_events(window);
 
-    system_timing.restart();
-    initialise_registry(registry, config.init_cell_count, config.arena_max_x,
-                        config.arena_max_y);
-    LOG("Initialise registry in " << system_timing.getElapsedTime().asSeconds()
-                                  << "s");
+        advance(world, config.jump);
+        checkpoints.advanced(world);
 
-    system_timing.restart();
-    render_system(window, config.scale, registry);
-    LOG("Ran render system in " << system_timing.getElapsedTime().asSeconds()
-                                << "s");
+        // Render once the generation is complete, so the renderer only has
+        // to patch the cells that changed in it
+        render_system(window, renderer, world);
+        instrument_poll(std::cerr);
+
+        if (!has_alive_cells(world)) {
+            LOG("No cells left alive");
+            break;
+        } else if (config.max_rounds != -1 && rounds >= config.max_rounds) {
+            LOG("Reached max number of rounds " << config.max_rounds);
+            break;
+        }
+    }
+    checkpoints.finish(world);
+
+    LOG("Finished the game of life");
+    LOG("Ran for " << clock.getElapsedTime().asSeconds() << "s");
+    LOG(rounds << " rounds");
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Run the simulation without a window or rendering, to measure the compute
+ * throughput alone.
+ */
+template <typename World>
+int simulate_headless(const Config &config, World &world) {
+    auto max_rounds = config.max_rounds != -1 ? config.max_rounds : 1000;
+    Checkpointer checkpoints(config);
+
+    auto start = std::chrono::steady_clock::now();
     int rounds = 0;
-    while (window.isOpen()) {
-        round_timing.restart();
+    while (rounds < max_rounds) {
+        GOL_TIME("round");
         rounds++;
-        sf::Event e;
-        while (window.pollEvent(e)) {
-            switch (e.type) {
-            case sf::Event::Closed:
-                window.close();
+        advance(world, config.jump);
+        checkpoints.advanced(world);
+        instrument_poll(std::cerr);
+
+        if (!has_alive_cells(world)) {
+            LOG("No cells left alive");
+            break;
+        }
+    }
+    auto seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    checkpoints.finish(world);
+
+    auto cells = static_cast<double>(config.arena_max_x) * config.arena_max_y;
+    auto generations = static_cast<double>(rounds) * config.jump;
+    std::cout << generations << " generations in " << seconds << "s"
+              << std::endl
+              << generations / seconds << " generations/s" << std::endl
+              << cells * generations / seconds << " cells/s" << std::endl;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Run the simulation with generations computed on their own thread while the
+ * main thread renders and handles the window's events.
+ *
+ * The compute thread publishes a snapshot of the live cells after each
+ * generation and carries straight on with the next. The main thread renders
+ * the latest snapshot whenever there is a new one, so a generation takes
+ * about as long as the slower of the two rather than both together.
+ */
+template <typename World>
+int simulate_pipelined(const Config &config, World &world) {
+    sf::VideoMode mode = sf::VideoMode(config.arena_max_x, config.arena_max_y);
+    sf::RenderWindow window(mode, "Game of Life");
+    CellRenderer renderer(config.arena_max_x, config.arena_max_y, config.scale);
+    SnapshotBuffer snapshots;
+    Checkpointer checkpoints(config);
+    sf::Clock clock;
+
+    // Counted the same way as the checkpoints, from a restored generation
+    // and by the generations each round jumps
+    auto generation_after = [&](int n_rounds) {
+        return static_cast<std::int64_t>(config.first_generation +
+                                         n_rounds * config.jump);
+    };
+    snapshot_system(world, snapshots.back());
+    snapshots.back().generation = generation_after(0);
+    snapshots.publish();
+
+    std::atomic<bool> stop(false);
+    std::atomic<bool> done(false);
+    std::atomic<int> rounds(0);
+    std::thread compute([&] {
+        while (!stop) {
+            GOL_TIME("round");
+            advance(world, config.jump);
+            checkpoints.advanced(world);
+            rounds++;
+
+            auto &snapshot = snapshots.back();
+            snapshot_system(world, snapshot);
+            snapshot.generation = generation_after(rounds);
+            snapshots.publish();
+
+            if (!has_alive_cells(world)) {
+                LOG("No cells left alive");
                 break;
-            default:
+            } else if (config.max_rounds != -1 &&
+                       rounds >= config.max_rounds) {
+                LOG("Reached max number of rounds " << config.max_rounds);
                 break;
             }
         }
+        done = true;
+    });
 
-        system_timing.restart();
-        lifecycle_system(registry);
-        LOG("Ran lifecycle system in "
-            << system_timing.getElapsedTime().asSeconds() << "s");
+    int frames = 0;
+    while (window.isOpen()) {
+        poll_events(window);
 
-        system_timing.restart();
-        render_system(window, config.scale, registry);
-        LOG("Ran render system in "
-            << system_timing.getElapsedTime().asSeconds() << "s");
+        // Read before acquiring so the last snapshot is always rendered
+        auto finished = done.load();
+        if (snapshots.acquire()) {
+            render_system(window, renderer, snapshots.front());
+            frames++;
+            instrument_poll(std::cerr);
+        } else if (finished) {
+            break;
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    stop = true;
+    compute.join();
+    checkpoints.finish(world);
 
+    LOG("Finished the game of life");
+    LOG("Ran for " << clock.getElapsedTime().asSeconds() << "s");
+    LOG(rounds << " rounds, " << frames << " frames rendered");
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Run the simulation in a window, or headless if asked to, then report the
+ * time spent in each system.
+ */
+template <typename World> int run(const Config &config, World &world) {
+    int status;
+    if (config.headless) {
+        status = simulate_headless(config, world);
+    } else if (config.pipelined) {
+        status = simulate_pipelined(config, world);
+    } else {
+        status = simulate(config, world);
+    }
+    LOG_FLUSH();
+    instrument_report(std::cerr);
+    return status;
+}
+
+/**
+ * Exit with an error for a pattern or checkpoint that can't be read.
+ */
+[[noreturn]] void bad_file(const char *kind, const std::string &path) {
+    LOG_FLUSH();
+    std::cerr << "Can't read the " << kind << " in " << path << std::endl;
+    std::exit(1);
+}
+
+[[noreturn]] void arena_too_big(const Config &config) {
+    LOG_FLUSH();
+    std::cerr << "An arena of " << config.arena_max_x << "x"
+              << config.arena_max_y << " has too many cells for the "
+              << config.backend << " backend" << std::endl;
+    std::exit(1);
+}
+
+int main(int argc, char *argv[]) {
+    Config config;
+    parse_args(argc - 1, argv + 1, config);
+    instrument_report_on_signal();
+    if (config.help || (!config.pattern.empty() && !config.restore.empty())) {
+        usage(argv[0]);
+        std::exit(1);
+    }
+
+    // Only the headers are read here, the cells are streamed straight into
+    // the world below
+    PatternFile pattern;
+    auto from_pattern = !config.pattern.empty();
+    if (from_pattern) {
+        if (!pattern.open(config.pattern)) {
+            bad_file("pattern", config.pattern);
+        }
+        if (pattern.has_rule() && !config.rule_given) {
+            config.rule = pattern.rule();
+        }
+    }
+
+    // A checkpoint brings its own arena and carries on counting generations
+    // from where it was taken
+    CheckpointFile checkpoint;
+    auto from_checkpoint = !config.restore.empty();
+    if (from_checkpoint) {
+        if (!checkpoint.open(config.restore)) {
+            bad_file("checkpoint", config.restore);
+        }
+        config.arena_max_x = checkpoint.width();
+        config.arena_max_y = checkpoint.height();
+        config.first_generation = checkpoint.generation();
+        if (!config.rule_given) {
+            config.rule = checkpoint.rule();
+        }
+        if (!config.topology_given) {
+            config.topology = checkpoint.topology();
+        }
+        LOG("Restoring generation " << checkpoint.generation() << " from "
+                                    << config.restore);
+    }
+
+    LOG("Starting the game of life with seed "
+        << config.seed << ", rule " << rule_name(config.rule)
+        << " and topology " << topology_name(config.topology));
+    instrument_set_cell_count(std::uint64_t(config.arena_max_x) *
+                              std::uint64_t(config.arena_max_y));
+    if (config.perf && !instrument_count_events()) {
+        LOG_WARNING("Hardware counters are unavailable, only timing the "
+                    "systems. Check /proc/sys/kernel/perf_event_paranoid");
+    }
+    sf::Clock system_timing;
+    RandGen rand_gen(config.seed);
+
+    if (config.backend == "bitgrid") {
+        BitGrid grid(config.arena_max_x, config.arena_max_y);
+        grid.set_rule(config.rule);
+        grid.set_topology(config.topology);
         system_timing.restart();
-        cleanup_system(registry);
-        LOG("Ran cleanup system in "
+        if (from_checkpoint) {
+            if (!restore_grid(grid, checkpoint)) {
+                bad_file("checkpoint", config.restore);
+            }
+        } else if (from_pattern) {
+            if (!load_grid(grid, pattern)) {
+                bad_file("pattern", config.pattern);
+            }
+        } else {
+            initialise_grid(grid, config.init_cell_count, rand_gen);
+        }
+        LOG("Initialise grid in "
             << system_timing.getElapsedTime().asSeconds() << "s");
-
+        return run(config, grid);
+    } else if (config.backend == "hashlife") {
+        // The universe is unbounded, there are no edges to join
+        if (config.topology != Topology::dead) {
+            LOG_FLUSH();
+            std::cerr << "The hashlife backend doesn't support wrapped "
+                         "topologies such as "
+                      << topology_name(config.topology)
+                      << ", its universe is unbounded" << std::endl;
+            std::exit(1);
+        }
+        Hashlife life(config.rule);
         system_timing.restart();
-        update_system(registry);
-        LOG("Ran render system in "
+        if (from_checkpoint) {
+            if (!restore_hashlife(life, checkpoint)) {
+                bad_file("checkpoint", config.restore);
+            }
+        } else if (from_pattern) {
+            if (!load_hashlife(life, pattern, config.arena_max_x,
+                               config.arena_max_y)) {
+                bad_file("pattern", config.pattern);
+            }
+        } else if (!initialise_hashlife(life, config.init_cell_count,
+                                        config.arena_max_x,
+                                        config.arena_max_y, rand_gen)) {
+            arena_too_big(config);
+        }
+        LOG("Initialise hashlife in "
             << system_timing.getElapsedTime().asSeconds() << "s");
+        return run(config, life);
+    } else if (config.backend != "ecs" && config.backend != "sparse") {
+        usage(argv[0]);
+        std::exit(1);
+    }
 
-        LOG("Round took " << round_timing.getElapsedTime().asSeconds() << "s");
+    // Every cell of a dense arena is an entity
+    auto sparse = config.backend == "sparse";
+    if (!sparse && !arena_fits_index(config.arena_max_x, config.arena_max_y)) {
+        arena_too_big(config);
+    }
 
-        if (!has_alive_cells(registry)) {
-            LOG("No cells left alive");
-            break;
-        } else if (config.max_rounds != -1 && rounds >= config.max_rounds) {
-            LOG("Reached max number of rounds " << config.max_rounds);
-            break;
+    entt::registry registry;
+    registry.set<Rule>(config.rule);
+    registry.set<Topology>(config.topology);
+    system_timing.restart();
+    if (from_checkpoint) {
+        if (!(sparse ? restore_sparse_registry(registry, checkpoint)
+                     : restore_registry(registry, checkpoint))) {
+            bad_file("checkpoint", config.restore);
+        }
+    } else if (from_pattern) {
+        if (!(sparse ? load_sparse_registry(registry, pattern,
+                                            config.arena_max_x,
+                                            config.arena_max_y)
+                     : load_registry(registry, pattern, config.arena_max_x,
+                                     config.arena_max_y))) {
+            bad_file("pattern", config.pattern);
         }
+    } else if (sparse) {
+        initialise_sparse_registry(registry, config.init_cell_count,
+                                   config.arena_max_x, config.arena_max_y,
+                                   rand_gen);
+    } else if (!initialise_registry(registry, config.init_cell_count,
+                                    config.arena_max_x, config.arena_max_y,
+                                    rand_gen)) {
+        arena_too_big(config);
     }
 
-    LOG("Finished the game of life");
-    LOG("Ran for " << clock.getElapsedTime().asSeconds() << "s");
-    LOG(rounds << " rounds");
-
-    return EXIT_SUCCESS;
+    auto threads = config.threads > 0
+                       ? config.threads
+                       : static_cast<int>(std::thread::hardware_concurrency());
+    if (threads > 1) {
+        registry.set<ThreadPool>(threads);
+        instrument_set_thread_count(threads);
+        if (config.perf) {
+            LOG_WARNING("Hardware counters only count the main thread's "
+                        "share of the systems run on "
+                        << threads << " threads, use -t 1 to count it all");
+        }
+    }
+    LOG("Initialise registry in " << system_timing.getElapsedTime().asSeconds()
+                                  << "s");
+    return run(config, registry);
 }
@@ -0,0 +1,116 @@
+#include <cstddef>
+#include <string>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.hpp"
+
+// An empty file has nothing to map, it is viewed through this instead
+static const char empty_file[1] = {0};
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile()
+    : begin(nullptr), length(0), file_handle(INVALID_HANDLE_VALUE),
+      mapping_handle(nullptr) {}
+
+bool MappedFile::open(const std::string &path) {
+    close();
+    file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    LARGE_INTEGER file_size;
+    if (file_handle == INVALID_HANDLE_VALUE ||
+        !GetFileSizeEx(file_handle, &file_size)) {
+        close();
+        return false;
+    }
+    length = static_cast<std::size_t>(file_size.QuadPart);
+    if (length == 0) {
+        begin = empty_file;
+        return true;
+    }
+
+    mapping_handle =
+        CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle) {
+        begin = static_cast<const char *>(
+            MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!begin) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (begin && begin != empty_file) {
+        UnmapViewOfFile(begin);
+    }
+    if (mapping_handle) {
+        CloseHandle(mapping_handle);
+    }
+    if (file_handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_handle);
+    }
+    begin = nullptr;
+    length = 0;
+    file_handle = INVALID_HANDLE_VALUE;
+    mapping_handle = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile() : begin(nullptr), length(0) {}
+
+bool MappedFile::open(const std::string &path) {
+    close();
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    length = static_cast<std::size_t>(info.st_size);
+    if (length == 0) {
+        ::close(fd);
+        begin = empty_file;
+        return true;
+    }
+
+    // The mapping stays valid once the descriptor is closed
+    auto mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        length = 0;
+        return false;
+    }
+    madvise(mapped, length, MADV_SEQUENTIAL);
+    begin = static_cast<const char *>(mapped);
+    return true;
+}
+
+void MappedFile::close() {
+    if (begin && begin != empty_file) {
+        munmap(const_cast<char *>(begin), length);
+    }
+    begin = nullptr;
+    length = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile() { close(); }
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * A read-only view of a whole file mapped into memory.
+ *
+ * Pages are read in from disk as they are touched and can be dropped again by
+ * the OS, so a file much larger than memory can be streamed through
+ * front to back. The mapping is advised as sequential where the platform
+ * supports it.
+ */
+class MappedFile {
+  public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * Map the file at path, unmapping any file mapped before. Returns false
+     * if it can't be opened or mapped.
+     */
+    bool open(const std::string &path);
+    void close();
+
+    const char *data() const { return begin; }
+    std::size_t size() const { return length; }
+
+  private:
+    const char *begin;
+    std::size_t length;
+#if defined(_WIN32)
+    void *file_handle;
+    void *mapping_handle;
+#endif
+};
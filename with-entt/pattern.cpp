@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "cell_batcher.hpp"
+#include "components.hpp"
+#include "pattern.hpp"
+#include "rule.hpp"
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static const char *line_end(const char *p, const char *end) {
+    auto newline = std::memchr(p, '\n', end - p);
+    return newline ? static_cast<const char *>(newline) : end;
+}
+
+static const char *next_line(const char *p, const char *end) {
+    auto line = line_end(p, end);
+    return line == end ? end : line + 1;
+}
+
+static bool starts_with(const char *p, const char *end, const char *prefix) {
+    auto length = std::strlen(prefix);
+    return std::size_t(end - p) >= length &&
+           std::memcmp(p, prefix, length) == 0;
+}
+
+static const char *skip_spaces(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+/**
+ * Parse a signed integer at p, moving p past it.
+ */
+static bool parse_int(const char *&p, const char *end, std::int64_t &value) {
+    bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) {
+        p++;
+    }
+    if (p == end || *p < '0' || *p > '9') {
+        return false;
+    }
+    value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        if (value > (std::numeric_limits<std::int64_t>::max() - 9) / 10) {
+            return false;
+        }
+        value = value * 10 + (*p - '0');
+    }
+    if (negative) {
+        value = -value;
+    }
+    return true;
+}
+
+static std::string trim(const std::string &text) {
+    auto first = text.find_first_not_of(" \t\r");
+    auto last = text.find_last_not_of(" \t\r");
+    return first == std::string::npos ? std::string()
+                                      : text.substr(first, last - first + 1);
+}
+
+/**
+ * Parse a rule in B/S notation, or in the older S/B notation where the
+ * survival counts come first, such as "23/3".
+ */
+static bool parse_any_rule(const std::string &text, Rule &rule) {
+    if (parse_rule(text, rule)) {
+        return true;
+    }
+    auto slash = text.find('/');
+    if (slash == std::string::npos) {
+        return false;
+    }
+    return parse_rule("B" + text.substr(slash + 1) + "/S" +
+                          text.substr(0, slash),
+                      rule);
+}
+
+/**
+ * Move a position along by a run of n cells, failing rather than overflowing
+ * when the run is longer than any pattern could be.
+ */
+static bool advance(std::int64_t &coordinate, std::int64_t n) {
+    if (n > std::numeric_limits<std::int64_t>::max() - coordinate) {
+        return false;
+    }
+    coordinate += n;
+    return true;
+}
+
+static bool read_rle(const char *p, const char *end, CellBatcher &out) {
+    std::int64_t x = 0, y = 0, run = 0;
+    for (; p < end; p++) {
+        auto c = *p;
+        if (c >= '0' && c <= '9') {
+            if (run > (std::numeric_limits<std::int64_t>::max() - 9) / 10) {
+                return false;
+            }
+            run = run * 10 + (c - '0');
+            continue;
+        } else if (is_space(c)) {
+            continue;
+        }
+
+        auto n = run == 0 ? 1 : run;
+        run = 0;
+        if (c == 'b' || c == '.') {
+            if (!advance(x, n)) {
+                return false;
+            }
+        } else if (c == '$') {
+            if (!advance(y, n)) {
+                return false;
+            }
+            x = 0;
+        } else if (c == '!') {
+            break;
+        } else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+            // o, or any state other than dead in a multi-state pattern
+            auto run_x = x;
+            if (!advance(x, n)) {
+                return false;
+            }
+            out.add(run_x, y, n);
+        } else {
+            return false;
+        }
+    }
+    out.flush();
+    return true;
+}
+
+static bool read_plaintext(const char *p, const char *end, CellBatcher &out) {
+    std::int64_t y = 0;
+    for (; p < end; p = next_line(p, end), y++) {
+        auto line = line_end(p, end);
+        if (*p == '!') {
+            y--;
+            continue;
+        }
+        for (auto x = 0; p + x < line; x++) {
+            auto c = p[x];
+            if (c == 'O' || c == '*') {
+                out.add(x, y);
+            } else if (c != '.' && !is_space(c)) {
+                return false;
+            }
+        }
+    }
+    out.flush();
+    return true;
+}
+
+static bool read_life_106(const char *p, const char *end, CellBatcher &out) {
+    while (p < end) {
+        p = skip_spaces(p, end);
+        if (p == end) {
+            break;
+        } else if (*p == '\n' || *p == '#') {
+            p = next_line(p, end);
+            continue;
+        }
+
+        std::int64_t x, y;
+        if (!parse_int(p, end, x)) {
+            return false;
+        }
+        p = skip_spaces(p, end);
+        if (!parse_int(p, end, y)) {
+            return false;
+        }
+        p = skip_spaces(p, end);
+        if (p < end && *p != '\n') {
+            return false;
+        }
+        out.add(x, y);
+    }
+    out.flush();
+    return true;
+}
+
+PatternFile::PatternFile()
+    : begin(nullptr), body(nullptr), end(nullptr),
+      pattern_format(PatternFormat::rle), pattern_width(0), pattern_height(0),
+      rule_given(false), pattern_rule(conway_rule) {}
+
+bool PatternFile::open(const std::string &path) {
+    if (!file.open(path)) {
+        return false;
+    }
+    return view(file.data(), file.size());
+}
+
+bool PatternFile::view(const char *data, std::size_t size) {
+    begin = data;
+    end = data + size;
+    pattern_width = 0;
+    pattern_height = 0;
+    rule_given = false;
+    pattern_rule = conway_rule;
+    return read_header();
+}
+
+bool PatternFile::read_header() {
+    if (starts_with(begin, end, "#Life 1.06")) {
+        pattern_format = PatternFormat::life_106;
+        body = next_line(begin, end);
+        return true;
+    } else if (starts_with(begin, end, "#Life")) {
+        return false;
+    }
+
+    // RLE files start with # comment lines, then the header
+    auto p = begin;
+    while (p < end && (*p == '#' || *p == '\n' || *p == '\r')) {
+        p = next_line(p, end);
+    }
+    if (p < end && *p == 'x') {
+        pattern_format = PatternFormat::rle;
+        body = next_line(p, end);
+
+        // Comma separated key = value pairs, x and y are required
+        std::string header(p, line_end(p, end));
+        bool has_width = false, has_height = false;
+        std::size_t start = 0;
+        while (start < header.size()) {
+            auto comma = std::min(header.find(',', start), header.size());
+            auto item = header.substr(start, comma - start);
+            start = comma + 1;
+
+            auto equals = item.find('=');
+            if (equals == std::string::npos) {
+                return false;
+            }
+            auto key = trim(item.substr(0, equals));
+            auto value = trim(item.substr(equals + 1));
+            const char *value_begin = value.data();
+            std::int64_t number;
+            if (key == "x" || key == "y") {
+                if (!parse_int(value_begin, value.data() + value.size(),
+                               number) ||
+                    number < 0) {
+                    return false;
+                }
+                (key == "x" ? pattern_width : pattern_height) = number;
+                (key == "x" ? has_width : has_height) = true;
+            } else if (key == "rule") {
+                if (!parse_any_rule(value, pattern_rule)) {
+                    return false;
+                }
+                rule_given = true;
+            }
+        }
+        return has_width && has_height;
+    }
+
+    // Anything else must be plaintext, which doesn't give its size. The size
+    // is needed to place the first cell, so the lines are measured here, but
+    // only from their ends; the cells are parsed and checked in the one pass
+    // that reads them.
+    pattern_format = PatternFormat::plaintext;
+    body = begin;
+    for (p = begin; p < end; p = next_line(p, end)) {
+        if (*p == '!') {
+            continue;
+        }
+        auto line = line_end(p, end);
+        while (line > p && is_space(line[-1])) {
+            line--;
+        }
+        pattern_width = std::max<std::int64_t>(pattern_width, line - p);
+        pattern_height++;
+    }
+    return true;
+}
+
+bool PatternFile::read(std::int64_t x, std::int64_t y, const CellBatch &f,
+                       const CellBox &clip) const {
+    CellBatcher out(x, y, f, clip);
+    switch (pattern_format) {
+    case PatternFormat::rle:
+        return read_rle(body, end, out);
+    case PatternFormat::plaintext:
+        return read_plaintext(body, end, out);
+    case PatternFormat::life_106:
+        return read_life_106(body, end, out);
+    }
+    return false;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "cell_batcher.hpp"
+#include "components.hpp"
+#include "mapped_file.hpp"
+#include "rule.hpp"
+
+/**
+ * The pattern file formats that can be read.
+ */
+enum class PatternFormat {
+    // Run length encoded, .rle
+    rle,
+    // A grid of . and O, .cells
+    plaintext,
+    // One x y pair per live cell
+    life_106,
+};
+
+/**
+ * A Game of Life pattern file, read straight from a memory mapping.
+ *
+ * Opening a pattern only reads its header. Its live cells are then parsed
+ * from the mapping in one forward pass as they are read, and handed over in
+ * batches, so even a multi-gigabyte file is never held in memory as text or
+ * as a set of cells.
+ */
+class PatternFile {
+  public:
+    PatternFile();
+    PatternFile(const PatternFile &) = delete;
+    PatternFile &operator=(const PatternFile &) = delete;
+
+    /**
+     * Map the file at path and read its header. Returns false if it can't be
+     * mapped or isn't in a known format. Plaintext has no header, so its
+     * cells are only checked as they are read.
+     */
+    bool open(const std::string &path);
+
+    /**
+     * Read the header of a pattern already in memory, which must outlive the
+     * PatternFile.
+     */
+    bool view(const char *data, std::size_t size);
+
+    PatternFormat format() const { return pattern_format; }
+
+    /**
+     * The size of the pattern's bounding box, or 0 if the format doesn't
+     * give it.
+     */
+    std::int64_t width() const { return pattern_width; }
+    std::int64_t height() const { return pattern_height; }
+
+    /**
+     * The rule given in the file, if there is one.
+     */
+    bool has_rule() const { return rule_given; }
+    Rule rule() const { return pattern_rule; }
+
+    /**
+     * Parse the live cells, passing them to f in batches, moved so the
+     * pattern's origin is at x, y. RLE and plaintext patterns have their
+     * origin at their top left corner, Life 1.06 patterns at 0, 0. Cells
+     * outside of clip, by default the range of a Position, are skipped.
+     *
+     * Returns false if the cells are malformed, f may already have been
+     * called with the ones before the error.
+     */
+    bool read(std::int64_t x, std::int64_t y, const CellBatch &f,
+              const CellBox &clip = CellBox::positions()) const;
+
+  private:
+    bool read_header();
+
+    MappedFile file;
+    const char *begin;
+    const char *body;
+    const char *end;
+    PatternFormat pattern_format;
+    std::int64_t pattern_width;
+    std::int64_t pattern_height;
+    bool rule_given;
+    Rule pattern_rule;
+};
@@ -0,0 +1,114 @@
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "components.hpp"
+#include "pattern.hpp"
+
+/**
+ * A dim x dim soup, about a third alive, written out as an RLE, plaintext or
+ * Life 1.06 pattern.
+ */
+static std::string make_pattern(PatternFormat format, int dim) {
+    std::mt19937 rand_gen(42);
+    std::bernoulli_distribution alive(1.0 / 3);
+    std::string text;
+    if (format == PatternFormat::rle) {
+        text = "x = " + std::to_string(dim) + ", y = " + std::to_string(dim) +
+               ", rule = B3/S23\n";
+    } else if (format == PatternFormat::life_106) {
+        text = "#Life 1.06\n";
+    }
+
+    for (auto y = 0; y < dim; y++) {
+        // Runs are only written for RLE, where the line length doesn't matter
+        char run_cell = 0;
+        int run = 0;
+        auto end_run = [&] {
+            if (run > 1) {
+                text += std::to_string(run);
+            }
+            if (run > 0) {
+                text += run_cell;
+            }
+        };
+        for (auto x = 0; x < dim; x++) {
+            auto is_alive = alive(rand_gen);
+            if (format == PatternFormat::plaintext) {
+                text += is_alive ? 'O' : '.';
+            } else if (format == PatternFormat::life_106 && is_alive) {
+                text += std::to_string(x) + " " + std::to_string(y) + "\n";
+            } else if (format == PatternFormat::rle) {
+                char cell = is_alive ? 'o' : 'b';
+                if (cell != run_cell) {
+                    end_run();
+                    run_cell = cell;
+                    run = 0;
+                }
+                run++;
+            }
+        }
+        if (format == PatternFormat::rle) {
+            end_run();
+            text += y + 1 < dim ? "$\n" : "!\n";
+        } else if (format == PatternFormat::plaintext) {
+            text += '\n';
+        }
+    }
+    return text;
+}
+
+/**
+ * Parse a generated pattern through a mapping of a temporary file, the same
+ * way -p does, counting the cells read.
+ */
+static void parse_pattern(benchmark::State &state, PatternFormat format,
+                          const char *name) {
+    auto text = make_pattern(format, static_cast<int>(state.range(0)));
+    auto path = std::filesystem::temp_directory_path() / name;
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << text;
+    }
+
+    PatternFile pattern;
+    if (!pattern.open(path.string())) {
+        state.SkipWithError("couldn't open the pattern");
+        return;
+    }
+    for (auto _ : state) {
+        std::size_t cells = 0;
+        pattern.read(0, 0, [&](const Position *, std::size_t n_cells) {
+            cells += n_cells;
+        });
+        benchmark::DoNotOptimize(cells);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+    std::filesystem::remove(path);
+}
+
+static void BM_parse_rle(benchmark::State &state) {
+    parse_pattern(state, PatternFormat::rle, "gol_bench.rle");
+}
+BENCHMARK(BM_parse_rle)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+
+static void BM_parse_plaintext(benchmark::State &state) {
+    parse_pattern(state, PatternFormat::plaintext, "gol_bench.cells");
+}
+BENCHMARK(BM_parse_plaintext)
+    ->Arg(1024)
+    ->Arg(4096)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_parse_life_106(benchmark::State &state) {
+    parse_pattern(state, PatternFormat::life_106, "gol_bench.lif");
+}
+BENCHMARK(BM_parse_life_106)
+    ->Arg(1024)
+    ->Arg(4096)
+    ->Unit(benchmark::kMillisecond);
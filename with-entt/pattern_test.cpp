@@ -0,0 +1,206 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+
+#include <doctest.h>
+
+#include "components.hpp"
+#include "mapped_file.hpp"
+#include "pattern.hpp"
+#include "rule.hpp"
+
+std::set<Position> read_cells(const PatternFile &pattern, std::int64_t x = 0,
+                              std::int64_t y = 0) {
+    std::set<Position> cells;
+    REQUIRE(pattern.read(x, y, [&](const Position *batch, std::size_t n) {
+        cells.insert(batch, batch + n);
+    }));
+    return cells;
+}
+
+const std::set<Position> glider = {Position(1, 0), Position(2, 1),
+                                   Position(0, 2), Position(1, 2),
+                                   Position(2, 2)};
+
+TEST_SUITE("PatternFile") {
+    TEST_CASE("RLE patterns are read with their size and rule") {
+        std::string text = "#N Glider\n"
+                           "#C A comment\n"
+                           "x = 3, y = 3, rule = B36/S23\n"
+                           "bo$2bo$3o!\n";
+        PatternFile pattern;
+        REQUIRE(pattern.view(text.data(), text.size()));
+        REQUIRE(pattern.format() == PatternFormat::rle);
+        REQUIRE(pattern.width() == 3);
+        REQUIRE(pattern.height() == 3);
+        REQUIRE(pattern.has_rule());
+        REQUIRE(pattern.rule() == highlife_rule);
+        REQUIRE(read_cells(pattern) == glider);
+    }
+
+    TEST_CASE("RLE runs span lines and rows") {
+        std::string text = "x = 5, y = 4\r\n"
+                           "2o\r\n"
+                           "3o2$o4!";
+        PatternFile pattern;
+        REQUIRE(pattern.view(text.data(), text.size()));
+        REQUIRE_FALSE(pattern.has_rule());
+        REQUIRE(read_cells(pattern, 10, 20) ==
+                std::set<Position>{Position(10, 20), Position(11, 20),
+                                   Position(12, 20), Position(13, 20),
+                                   Position(14, 20), Position(10, 22)});
+    }
+
+    TEST_CASE("RLE rules can be given survival first") {
+        std::string text = "x = 0, y = 0, rule = 23/36\n!";
+        PatternFile pattern;
+        REQUIRE(pattern.view(text.data(), text.size()));
+        REQUIRE(pattern.rule() == highlife_rule);
+    }
+
+    TEST_CASE("plaintext patterns are read with their size") {
+        std::string text = "!Name: Glider\n"
+                           ".O\n"
+                           "..O\n"
+                           "OOO\n";
+        PatternFile pattern;
+        REQUIRE(pattern.view(text.data(), text.size()));
+        REQUIRE(pattern.format() == PatternFormat::plaintext);
+        REQUIRE(pattern.width() == 3);
+        REQUIRE(pattern.height() == 3);
+        REQUIRE(read_cells(pattern) == glider);
+    }
+
+    TEST_CASE("Life 1.06 patterns are read around their origin") {
+        std::string text = "#Life 1.06\n"
+                           "0 -1\n"
+                           "1 0\n"
+                           "-1 1\n"
+                           "  0 1\r\n"
+                           "1 1";
+        PatternFile pattern;
+        REQUIRE(pattern.view(text.data(), text.size()));
+        REQUIRE(pattern.format() == PatternFormat::life_106);
+        REQUIRE(pattern.width() == 0);
+        REQUIRE(read_cells(pattern, 1, 1) == glider);
+    }
+
+    TEST_CASE("malformed patterns are rejected") {
+        PatternFile pattern;
+        for (std::string text :
+             {"#Life 1.05\n*.\n", "x = 3\nbo!", "x = 3, y = 3, rule = Q\n"}) {
+            CAPTURE(text);
+            REQUIRE_FALSE(pattern.view(text.data(), text.size()));
+        }
+        // The runs in the last two carry the position past the range of an
+        // int64
+        for (std::string text :
+             {"x = 3, y = 3\nbo$2b?o!", "#Life 1.06\n1\n",
+              "#Life 1.06\n1 2 3\n", ".O\nOX\n",
+              "x = 3, y = 3\n9000000000000000000b9000000000000000000o!",
+              "x = 3, y = 3\n9000000000000000000$9000000000000000000$o!"}) {
+            CAPTURE(text);
+            REQUIRE(pattern.view(text.data(), text.size()));
+            REQUIRE_FALSE(pattern.read(0, 0, [](const Position *,
+                                                std::size_t) {}));
+        }
+    }
+
+    TEST_CASE("cells are handed over in batches") {
+        std::string text = "x = 10000, y = 1\n10000o!";
+        PatternFile pattern;
+        REQUIRE(pattern.view(text.data(), text.size()));
+
+        std::size_t batches = 0, cells = 0;
+        REQUIRE(pattern.read(0, 0, [&](const Position *, std::size_t n) {
+            batches++;
+            cells += n;
+        }));
+        REQUIRE(cells == 10000);
+        REQUIRE(batches > 1);
+    }
+
+    TEST_CASE("cells beyond the range of a Position are skipped") {
+        std::string text = "#Life 1.06\n"
+                           "5 5\n"
+                           "4000000000 0\n"
+                           "0 -4000000000\n";
+        PatternFile pattern;
+        REQUIRE(pattern.view(text.data(), text.size()));
+        REQUIRE(read_cells(pattern) == std::set<Position>{Position(5, 5)});
+    }
+
+    TEST_CASE("cells are clipped to a box") {
+        // Walking this run a cell at a time would take seconds
+        std::string text = "x = 999999999999, y = 3\n"
+                           "999999999998o$b2o$999999999999o!";
+        PatternFile pattern;
+        REQUIRE(pattern.view(text.data(), text.size()));
+
+        std::set<Position> cells;
+        REQUIRE(pattern.read(
+            -999999999990, 5,
+            [&](const Position *batch, std::size_t n) {
+                cells.insert(batch, batch + n);
+            },
+            CellBox{0, 5, 10, 7}));
+        std::set<Position> expected;
+        for (auto x = 0; x < 8; x++) {
+            expected.insert(Position(x, 5));
+        }
+        REQUIRE(cells == expected);
+
+        cells.clear();
+        REQUIRE(pattern.read(
+            0, 0,
+            [&](const Position *batch, std::size_t n) {
+                cells.insert(batch, batch + n);
+            },
+            CellBox{1, 1, 3, 3}));
+        REQUIRE(cells == std::set<Position>{Position(1, 1), Position(2, 1),
+                                            Position(1, 2), Position(2, 2)});
+    }
+
+    TEST_CASE("patterns are read from mapped files") {
+        auto path = std::filesystem::temp_directory_path() /
+                    "gol_pattern_test.rle";
+        {
+            std::ofstream file(path, std::ios::binary);
+            file << "x = 3, y = 3\nbo$2bo$3o!\n";
+        }
+
+        PatternFile pattern;
+        REQUIRE(pattern.open(path.string()));
+        REQUIRE(read_cells(pattern) == glider);
+        std::filesystem::remove(path);
+
+        REQUIRE_FALSE(pattern.open(path.string()));
+    }
+}
+
+TEST_SUITE("MappedFile") {
+    TEST_CASE("files are mapped whole") {
+        auto path = std::filesystem::temp_directory_path() /
+                    "gol_mapped_file_test";
+        std::string contents(100000, 'x');
+        contents[99999] = 'y';
+        {
+            std::ofstream file(path, std::ios::binary);
+            file << contents;
+        }
+
+        MappedFile file;
+        REQUIRE(file.open(path.string()));
+        REQUIRE(file.size() == contents.size());
+        REQUIRE(std::string(file.data(), file.size()) == contents);
+
+        { std::ofstream empty(path, std::ios::binary | std::ios::trunc); }
+        REQUIRE(file.open(path.string()));
+        REQUIRE(file.size() == 0);
+        std::filesystem::remove(path);
+    }
+}
@@ -0,0 +1,141 @@
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "perf_counters.hpp"
+
+const char *perf_event_name(PerfEvent event) {
+    switch (event) {
+    case perf_cycles:
+        return "cycles";
+    case perf_instructions:
+        return "instructions";
+    case perf_l1d_misses:
+        return "L1d misses";
+    case perf_llc_misses:
+        return "LLC misses";
+    case perf_branch_misses:
+        return "branch misses";
+    default:
+        return "";
+    }
+}
+
+#if defined(__linux__)
+
+static void describe(PerfEvent event, perf_event_attr &attr) {
+    const std::uint64_t l1d_read_miss =
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.type = PERF_TYPE_HARDWARE;
+    switch (event) {
+    case perf_cycles:
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case perf_instructions:
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case perf_l1d_misses:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = l1d_read_miss;
+        break;
+    case perf_llc_misses:
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+    default:
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+}
+
+PerfCounters::PerfCounters() : n_opened(0) {
+    fds.fill(-1);
+    group_index.fill(-1);
+    for (auto i = 0; i < n_perf_events; i++) {
+        auto event = static_cast<PerfEvent>(i);
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        describe(event, attr);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP |
+                           PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // The group is started once its members are all in it
+        auto leader = fds[perf_cycles];
+        attr.disabled = leader < 0;
+
+        auto fd = static_cast<int>(
+            syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+        if (fd < 0 && event == perf_cycles) {
+            return;
+        } else if (fd >= 0) {
+            fds[i] = fd;
+            group_index[i] = n_opened++;
+        }
+    }
+    ioctl(fds[perf_cycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+PerfCounters::~PerfCounters() {
+    for (auto fd : fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+bool PerfCounters::read(PerfReading &reading) const {
+    if (!available()) {
+        return false;
+    }
+    // The number of events, the times, then each event's count
+    std::array<std::uint64_t, 3 + n_perf_events> values;
+    auto size = static_cast<ssize_t>((3 + n_opened) * sizeof(std::uint64_t));
+    if (::read(fds[perf_cycles], values.data(), size) != size) {
+        return false;
+    }
+    reading.enabled = values[1];
+    reading.running = values[2];
+    for (auto i = 0; i < n_perf_events; i++) {
+        auto index = group_index[i];
+        reading.counts[i] = index >= 0 ? values[3 + index] : 0;
+    }
+    return true;
+}
+
+#else
+
+PerfCounters::PerfCounters() : n_opened(0) {
+    fds.fill(-1);
+    group_index.fill(-1);
+}
+
+PerfCounters::~PerfCounters() {}
+
+bool PerfCounters::read(PerfReading &) const { return false; }
+
+#endif
+
+PerfCounts perf_difference(const PerfReading &start, const PerfReading &end) {
+    PerfCounts counts{};
+    auto enabled = end.enabled - start.enabled;
+    auto running = end.running - start.running;
+    if (running == 0) {
+        return counts;
+    }
+    auto scale = static_cast<double>(enabled) / running;
+    for (auto i = 0; i < n_perf_events; i++) {
+        counts[i] = static_cast<std::uint64_t>(
+            (end.counts[i] - start.counts[i]) * scale + 0.5);
+    }
+    return counts;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/**
+ * The hardware events counted, in the order they are read.
+ */
+enum PerfEvent {
+    perf_cycles,
+    perf_instructions,
+    perf_l1d_misses,
+    perf_llc_misses,
+    perf_branch_misses,
+    n_perf_events,
+};
+
+/**
+ * Short name of an event, for reports.
+ */
+const char *perf_event_name(PerfEvent event);
+
+typedef std::array<std::uint64_t, n_perf_events> PerfCounts;
+
+/**
+ * The counts of one thread's events so far, and for how long they were
+ * enabled and actually counting.
+ */
+struct PerfReading {
+    PerfCounts counts{};
+    std::uint64_t enabled = 0;
+    std::uint64_t running = 0;
+};
+
+/**
+ * The hardware counters of the thread that created them, opened as one
+ * group with perf_event_open so they are all read in a single call.
+ *
+ * Counters can be unavailable: on platforms other than Linux, in containers
+ * and virtual machines without a PMU, or when perf_event_paranoid forbids
+ * them. Events that can't be opened are left out and read as zero, and if
+ * cycles can't be counted nothing is.
+ */
+class PerfCounters {
+  public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    bool available() const { return fds[perf_cycles] >= 0; }
+    bool counts(PerfEvent event) const { return fds[event] >= 0; }
+
+    /**
+     * Read the counts so far, returning false if they couldn't be read.
+     */
+    bool read(PerfReading &reading) const;
+
+  private:
+    std::array<int, n_perf_events> fds;
+    // Where each event's count comes in a read of the group
+    std::array<int, n_perf_events> group_index;
+    int n_opened;
+};
+
+/**
+ * The events counted between two readings of the same counters, scaled up
+ * for any time the kernel had them switched out to share the PMU.
+ */
+PerfCounts perf_difference(const PerfReading &start, const PerfReading &end);
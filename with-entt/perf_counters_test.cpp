@@ -0,0 +1,71 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <cstdint>
+#include <string>
+
+#include <doctest.h>
+
+#include "perf_counters.hpp"
+
+TEST_SUITE("perf_difference") {
+    TEST_CASE("counts are the difference between the readings") {
+        PerfReading start, end;
+        start.counts = {100, 200, 3, 2, 1};
+        start.enabled = start.running = 1000;
+        end.counts = {600, 1200, 13, 7, 4};
+        end.enabled = end.running = 3000;
+
+        auto counts = perf_difference(start, end);
+        REQUIRE(counts[perf_cycles] == 500);
+        REQUIRE(counts[perf_instructions] == 1000);
+        REQUIRE(counts[perf_l1d_misses] == 10);
+        REQUIRE(counts[perf_llc_misses] == 5);
+        REQUIRE(counts[perf_branch_misses] == 3);
+    }
+
+    TEST_CASE("counts are scaled up for time the counters were switched out") {
+        PerfReading start, end;
+        end.counts[perf_cycles] = 400;
+        end.enabled = 1000;
+        end.running = 500;
+        REQUIRE(perf_difference(start, end)[perf_cycles] == 800);
+    }
+
+    TEST_CASE("counters that never ran count nothing") {
+        PerfReading start, end;
+        end.counts[perf_cycles] = 400;
+        end.enabled = 1000;
+        REQUIRE(perf_difference(start, end)[perf_cycles] == 0);
+    }
+}
+
+TEST_SUITE("PerfCounters") {
+    TEST_CASE("every event has a name") {
+        for (auto i = 0; i < n_perf_events; i++) {
+            REQUIRE(std::string(perf_event_name(PerfEvent(i))) != "");
+        }
+    }
+
+    // Whether there are counters depends on the machine, both ways have to
+    // work
+    TEST_CASE("counters count work or say they are unavailable") {
+        PerfCounters counters;
+        PerfReading start, end;
+        if (!counters.available()) {
+            REQUIRE_FALSE(counters.read(start));
+            return;
+        }
+
+        REQUIRE(counters.read(start));
+        volatile std::uint64_t sum = 0;
+        for (auto i = 0; i < 1000000; i++) {
+            sum = sum + i;
+        }
+        REQUIRE(counters.read(end));
+        auto counts = perf_difference(start, end);
+        REQUIRE(counts[perf_cycles] > 0);
+        if (counters.counts(perf_instructions)) {
+            REQUIRE(counts[perf_instructions] > 1000000);
+        }
+    }
+}
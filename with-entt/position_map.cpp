@@ -0,0 +1,10 @@
+#include "position_map.hpp"
+#include "components.hpp"
+
+PositionSet::PositionSet(std::size_t capacity) : positions(capacity) {}
+
+bool PositionSet::insert(Position pos) {
+    auto size_before = positions.size();
+    positions[pos] = 1;
+    return positions.size() != size_before;
+}
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "components.hpp"
+
+/**
+ * Flat, open addressing hash map from Position to Value.
+ *
+ * Keys and values live in two contiguous arrays probed linearly from the
+ * position's hash, so a lookup scans a run of adjacent 8 byte keys rather than
+ * chasing list nodes. The position (INT_MIN, INT_MIN) marks empty slots and
+ * can't be used as a key. Clearing keeps the capacity, so a map reused between
+ * generations stops allocating once it has grown.
+ */
+template <typename Value> class PositionMap {
+  public:
+    /**
+     * Iterates over the keys in the map, in no particular order.
+     */
+    class key_iterator {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Position value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Position *pointer;
+        typedef const Position &reference;
+
+        key_iterator(const Position *key_, const Position *end_)
+            : key(key_), end(end_) {
+            skip_empty();
+        }
+
+        reference operator*() const { return *key; }
+        pointer operator->() const { return key; }
+        key_iterator &operator++() {
+            ++key;
+            skip_empty();
+            return *this;
+        }
+        key_iterator operator++(int) {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+        bool operator==(const key_iterator &other) const {
+            return key == other.key;
+        }
+        bool operator!=(const key_iterator &other) const {
+            return key != other.key;
+        }
+
+      private:
+        void skip_empty() {
+            while (key != end && is_empty(*key)) {
+                ++key;
+            }
+        }
+
+        const Position *key;
+        const Position *end;
+    };
+
+    explicit PositionMap(std::size_t capacity = 0) { reserve(capacity); }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    /**
+     * Remove every entry, keeping the capacity.
+     */
+    void clear() {
+        std::fill(keys.begin(), keys.end(), empty_key());
+        std::fill(values.begin(), values.end(), Value());
+        count = 0;
+    }
+
+    /**
+     * Make room for n entries without rehashing.
+     */
+    void reserve(std::size_t n) {
+        std::size_t capacity = min_capacity;
+        while (capacity * max_load_num < n * max_load_den) {
+            capacity *= 2;
+        }
+        if (capacity > keys.size()) {
+            rehash(capacity);
+        }
+    }
+
+    /**
+     * The value for the key, inserting a default value if it is missing.
+     */
+    Value &operator[](Position key) {
+        if ((count + 1) * max_load_den > keys.size() * max_load_num) {
+            rehash(std::max(min_capacity, keys.size() * 2));
+        }
+        auto i = probe(key);
+        if (is_empty(keys[i])) {
+            keys[i] = key;
+            count++;
+        }
+        return values[i];
+    }
+
+    Value *find(Position key) {
+        if (keys.empty()) {
+            return nullptr;
+        }
+        auto i = probe(key);
+        return is_empty(keys[i]) ? nullptr : &values[i];
+    }
+
+    const Value *find(Position key) const {
+        return const_cast<PositionMap *>(this)->find(key);
+    }
+
+    bool contains(Position key) const { return find(key) != nullptr; }
+
+    /**
+     * Remove the key, returning whether it was present.
+     */
+    bool erase(Position key) {
+        if (keys.empty()) {
+            return false;
+        }
+        auto hole = probe(key);
+        if (is_empty(keys[hole])) {
+            return false;
+        }
+
+        // Shift back any following entries that would no longer be found
+        // past the hole, so probes never need tombstones.
+        auto mask = keys.size() - 1;
+        for (auto i = (hole + 1) & mask; !is_empty(keys[i]);
+             i = (i + 1) & mask) {
+            auto home = position_hash(keys[i]) & mask;
+            if (((i - home) & mask) >= ((i - hole) & mask)) {
+                keys[hole] = keys[i];
+                values[hole] = std::move(values[i]);
+                hole = i;
+            }
+        }
+        keys[hole] = empty_key();
+        values[hole] = Value();
+        count--;
+        return true;
+    }
+
+    /**
+     * Call f with each key and its value.
+     */
+    template <typename F> void each(F f) const {
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            if (!is_empty(keys[i])) {
+                f(keys[i], values[i]);
+            }
+        }
+    }
+
+    key_iterator keys_begin() const {
+        return key_iterator(keys.data(), keys.data() + keys.size());
+    }
+    key_iterator keys_end() const {
+        return key_iterator(keys.data() + keys.size(),
+                            keys.data() + keys.size());
+    }
+
+  private:
+    static constexpr std::size_t min_capacity = 16;
+    // Grow when more than 3/4 full
+    static constexpr std::size_t max_load_num = 3;
+    static constexpr std::size_t max_load_den = 4;
+
+    static Position empty_key() { return Position(INT_MIN, INT_MIN); }
+    static bool is_empty(const Position &pos) {
+        return pos.x == INT_MIN && pos.y == INT_MIN;
+    }
+
+    /**
+     * The slot holding the key, or the empty slot it would be inserted in.
+     */
+    std::size_t probe(Position key) const {
+        auto mask = keys.size() - 1;
+        auto i = position_hash(key) & mask;
+        while (!is_empty(keys[i]) &&
+               (keys[i].x != key.x || keys[i].y != key.y)) {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void rehash(std::size_t capacity) {
+        std::vector<Position> old_keys(capacity, empty_key());
+        std::vector<Value> old_values(capacity);
+        old_keys.swap(keys);
+        old_values.swap(values);
+        for (std::size_t i = 0; i < old_keys.size(); i++) {
+            if (!is_empty(old_keys[i])) {
+                auto slot = probe(old_keys[i]);
+                keys[slot] = old_keys[i];
+                values[slot] = std::move(old_values[i]);
+            }
+        }
+    }
+
+    std::vector<Position> keys;
+    std::vector<Value> values;
+    std::size_t count = 0;
+};
+
+/**
+ * Flat, open addressing set of positions, see PositionMap.
+ */
+class PositionSet {
+  public:
+    typedef PositionMap<char>::key_iterator const_iterator;
+
+    explicit PositionSet(std::size_t capacity = 0);
+
+    std::size_t size() const { return positions.size(); }
+    bool empty() const { return positions.empty(); }
+    void clear() { positions.clear(); }
+    void reserve(std::size_t n) { positions.reserve(n); }
+
+    /**
+     * Add the position, returning whether it was not already present.
+     */
+    bool insert(Position pos);
+    bool contains(Position pos) const { return positions.contains(pos); }
+    bool erase(Position pos) { return positions.erase(pos); }
+
+    const_iterator begin() const { return positions.keys_begin(); }
+    const_iterator end() const { return positions.keys_end(); }
+
+  private:
+    PositionMap<char> positions;
+};
@@ -0,0 +1,114 @@
+#include <cstddef>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "components.hpp"
+#include "position_map.hpp"
+#include "utils.hpp"
+
+/**
+ * The hash Position used to have, where every cell on a diagonal x == y
+ * collides and (x, y) collides with (y, x).
+ */
+struct XorPositionHash {
+    std::size_t operator()(const Position &pos) const {
+        return std::hash<int>()(pos.x) ^ std::hash<int>()(pos.y);
+    }
+};
+
+/**
+ * Every position in a dim x dim board and a shuffled mix of hits and misses
+ * to look up in it.
+ */
+static void make_board(int dim, std::vector<Position> &cells,
+                       std::vector<Position> &queries) {
+    for (auto x = 0; x < dim; x++) {
+        for (auto y = 0; y < dim; y++) {
+            cells.emplace_back(x, y);
+        }
+    }
+    std::mt19937 rand_gen(42);
+    std::uniform_int_distribution<> coord(-dim / 2, dim + dim / 2);
+    for (auto i = 0; i < 4096; i++) {
+        queries.emplace_back(coord(rand_gen), coord(rand_gen));
+    }
+}
+
+template <typename Set> static void lookup(benchmark::State &state) {
+    std::vector<Position> cells, queries;
+    make_board(static_cast<int>(state.range(0)), cells, queries);
+    Set set;
+    for (auto &pos : cells) {
+        set.insert(pos);
+    }
+
+    for (auto _ : state) {
+        std::size_t found = 0;
+        for (auto &pos : queries) {
+            found += set.find(pos) != set.end();
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+static void BM_lookup_unordered_set_xor_hash(benchmark::State &state) {
+    lookup<std::unordered_set<Position, XorPositionHash>>(state);
+}
+BENCHMARK(BM_lookup_unordered_set_xor_hash)->Arg(64)->Arg(256)->Arg(1024);
+
+static void BM_lookup_unordered_set(benchmark::State &state) {
+    lookup<std::unordered_set<Position>>(state);
+}
+BENCHMARK(BM_lookup_unordered_set)->Arg(64)->Arg(256)->Arg(1024);
+
+static void BM_lookup_position_set(benchmark::State &state) {
+    std::vector<Position> cells, queries;
+    make_board(static_cast<int>(state.range(0)), cells, queries);
+    PositionSet set;
+    for (auto &pos : cells) {
+        set.insert(pos);
+    }
+
+    for (auto _ : state) {
+        std::size_t found = 0;
+        for (auto &pos : queries) {
+            found += set.contains(pos);
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+BENCHMARK(BM_lookup_position_set)->Arg(64)->Arg(256)->Arg(1024);
+
+// Counting neighbours the way SparseGrid::rebuild does, reusing the map
+template <typename Map> static void count_neighbours(benchmark::State &state) {
+    std::vector<Position> cells, queries;
+    make_board(static_cast<int>(state.range(0)), cells, queries);
+    Map counts;
+
+    for (auto _ : state) {
+        counts.clear();
+        for (auto &pos : queries) {
+            for (auto &offset : neighbour_offsets) {
+                counts[Position(pos.x + offset.x, pos.y + offset.y)]++;
+            }
+        }
+        benchmark::DoNotOptimize(counts.size());
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size() * 8);
+}
+
+static void BM_count_neighbours_unordered_map(benchmark::State &state) {
+    count_neighbours<std::unordered_map<Position, int>>(state);
+}
+BENCHMARK(BM_count_neighbours_unordered_map)->Arg(256);
+
+static void BM_count_neighbours_position_map(benchmark::State &state) {
+    count_neighbours<PositionMap<int>>(state);
+}
+BENCHMARK(BM_count_neighbours_position_map)->Arg(256);
@@ -0,0 +1,102 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <doctest.h>
+
+#include "components.hpp"
+#include "position_map.hpp"
+
+TEST_SUITE("PositionMap") {
+    TEST_CASE("missing positions are not found") {
+        PositionMap<int> map;
+        REQUIRE(map.find(Position(1, 2)) == nullptr);
+        REQUIRE(!map.contains(Position(1, 2)));
+        REQUIRE(!map.erase(Position(1, 2)));
+        REQUIRE(map.empty());
+    }
+
+    TEST_CASE("values are default constructed on first access") {
+        PositionMap<int> map;
+        map[Position(-3, 7)]++;
+        map[Position(-3, 7)]++;
+        map[Position(7, -3)]++;
+
+        REQUIRE(map.size() == 2);
+        REQUIRE(*map.find(Position(-3, 7)) == 2);
+        REQUIRE(*map.find(Position(7, -3)) == 1);
+    }
+
+    TEST_CASE("matches std::map under random inserts and erases") {
+        std::mt19937 rand_gen(7);
+        std::uniform_int_distribution<> coord(-20, 20);
+        std::uniform_int_distribution<> op(0, 2);
+
+        PositionMap<int> map;
+        std::map<Position, int> expected;
+        for (auto i = 0; i < 5000; i++) {
+            Position pos(coord(rand_gen), coord(rand_gen));
+            if (op(rand_gen) == 0) {
+                REQUIRE(map.erase(pos) == (expected.erase(pos) == 1));
+            } else {
+                map[pos] = i;
+                expected[pos] = i;
+            }
+        }
+
+        REQUIRE(map.size() == expected.size());
+        for (auto &entry : expected) {
+            auto value = map.find(entry.first);
+            REQUIRE(value != nullptr);
+            REQUIRE(*value == entry.second);
+        }
+        auto visited = 0u;
+        map.each([&](const Position &pos, int value) {
+            REQUIRE(expected.at(pos) == value);
+            visited++;
+        });
+        REQUIRE(visited == expected.size());
+    }
+
+    TEST_CASE("clear keeps entries out but can be refilled") {
+        PositionMap<int> map;
+        for (auto x = 0; x < 100; x++) {
+            map[Position(x, x)] = x;
+        }
+        map.clear();
+
+        REQUIRE(map.empty());
+        REQUIRE(!map.contains(Position(5, 5)));
+        map[Position(5, 5)] = 1;
+        REQUIRE(map.size() == 1);
+    }
+}
+
+TEST_SUITE("PositionSet") {
+    TEST_CASE("insert reports whether the position was new") {
+        PositionSet set;
+        REQUIRE(set.insert(Position(1, 1)));
+        REQUIRE(!set.insert(Position(1, 1)));
+        REQUIRE(set.size() == 1);
+        REQUIRE(set.contains(Position(1, 1)));
+    }
+
+    TEST_CASE("iterates over each position once") {
+        PositionSet set;
+        std::set<Position> expected;
+        for (auto x = 0; x < 30; x++) {
+            for (auto y = 0; y < 30; y += 3) {
+                set.insert(Position(x, y));
+                expected.insert(Position(x, y));
+            }
+        }
+
+        std::vector<Position> visited(set.begin(), set.end());
+        REQUIRE(visited.size() == expected.size());
+        REQUIRE(std::set<Position>(visited.begin(), visited.end()) ==
+                expected);
+    }
+}
@@ -0,0 +1,9 @@
+#include <cstdint>
+#include <random>
+
+#include "random.hpp"
+
+std::uint64_t random_seed() {
+    std::random_device rand_dev;
+    return (static_cast<std::uint64_t>(rand_dev()) << 32) | rand_dev();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+/**
+ * The xoshiro256** generator by Blackman and Vigna.
+ *
+ * It is a UniformRandomBitGenerator, so it works with the standard
+ * distributions, but is much smaller and faster than std::mt19937 and cheap
+ * to seed.
+ */
+class Xoshiro256 {
+  public:
+    typedef std::uint64_t result_type;
+
+    /**
+     * Seed all 256 bits of state from a 64-bit seed with SplitMix64, as the
+     * authors recommend.
+     */
+    explicit Xoshiro256(std::uint64_t seed_) {
+        for (auto &word : state) {
+            seed_ += 0x9e3779b97f4a7c15ULL;
+            auto z = seed_;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()() {
+        auto result = rotl(state[1] * 5, 7) * 9;
+        auto t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+  private:
+    static std::uint64_t rotl(std::uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    std::uint64_t state[4];
+};
+
+/**
+ * The engine boards are seeded with. Any UniformRandomBitGenerator
+ * constructible from a 64-bit seed, such as std::mt19937_64, can be swapped
+ * in here.
+ */
+typedef Xoshiro256 RandGen;
+
+/**
+ * A fresh, non-deterministic seed for runs that weren't given one.
+ */
+std::uint64_t random_seed();
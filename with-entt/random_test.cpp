@@ -0,0 +1,52 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <doctest.h>
+
+#include "random.hpp"
+
+static std::vector<RandGen::result_type> draw(RandGen &rand_gen, int n) {
+    std::vector<RandGen::result_type> values(n);
+    std::generate(values.begin(), values.end(), rand_gen);
+    return values;
+}
+
+TEST_SUITE("RandGen") {
+    TEST_CASE("the same seed gives the same sequence") {
+        RandGen rand_gen_0(1234), rand_gen_1(1234);
+        REQUIRE(draw(rand_gen_0, 100) == draw(rand_gen_1, 100));
+    }
+
+    TEST_CASE("different seeds give different sequences") {
+        RandGen rand_gen_0(1234), rand_gen_1(1235);
+        REQUIRE(draw(rand_gen_0, 100) != draw(rand_gen_1, 100));
+    }
+
+    TEST_CASE("a zero seed doesn't give a zero state") {
+        RandGen rand_gen(0);
+        auto values = draw(rand_gen, 100);
+        REQUIRE(std::count(values.begin(), values.end(), 0u) < 2);
+    }
+
+    TEST_CASE("works with the standard distributions") {
+        RandGen rand_gen(42);
+        std::uniform_int_distribution<> dist(0, 9);
+        std::vector<int> counts(10, 0);
+        for (auto i = 0; i < 10000; i++) {
+            counts[dist(rand_gen)]++;
+        }
+
+        // Each bucket expects 1000, this is more than six sigma either side
+        for (auto count : counts) {
+            CHECK(count > 800);
+            CHECK(count < 1200);
+        }
+    }
+}
+
+TEST_CASE("random seeds differ between calls") {
+    REQUIRE(random_seed() != random_seed());
+}
@@ -0,0 +1,85 @@
+#include <cstdint>
+
+#include <benchmark/benchmark.h>
+
+#include <SFML/Graphics.hpp>
+
+#include "bitgrid.hpp"
+#include "components.hpp"
+#include "random.hpp"
+#include "renderer.hpp"
+#include "systems.hpp"
+
+// Frame time should stay flat as the number of live cells grows, the board is
+// always a single draw call. Needs a graphics context for the render texture.
+static void BM_render_frame(benchmark::State &state) {
+    const int dim = 1024;
+    BitGrid grid(dim, dim);
+    RandGen rand_gen(42);
+    initialise_grid(grid, static_cast<int>(state.range(0)), rand_gen);
+
+    sf::RenderTexture target;
+    if (!target.create(dim, dim)) {
+        state.SkipWithError("Couldn't create a render texture");
+        return;
+    }
+    CellRenderer renderer(dim, dim, 1);
+
+    for (auto _ : state) {
+        renderer.clear();
+        grid.each_alive([&](Position pos) { renderer.set(pos, true); });
+        target.clear(sf::Color::Black);
+        renderer.draw(target);
+        target.display();
+    }
+    state.counters["live_cells"] = static_cast<double>(state.range(0));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_render_frame)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Arg(500000)
+    ->Unit(benchmark::kMillisecond);
+
+// Once a board has mostly settled into still lifes, patching the cells that
+// changed should cost far less than redrawing every live cell as above.
+static void BM_render_frame_incremental(benchmark::State &state) {
+    const int dim = 1024;
+    BitGrid grid(dim, dim);
+    RandGen rand_gen(42);
+    initialise_grid(grid, static_cast<int>(state.range(0)), rand_gen);
+    for (auto round = 0; round < 500; round++) {
+        lifecycle_system(grid);
+        update_system(grid);
+    }
+
+    sf::RenderTexture target;
+    if (!target.create(dim, dim)) {
+        state.SkipWithError("Couldn't create a render texture");
+        return;
+    }
+    CellRenderer renderer(dim, dim, 1);
+    update_renderer(renderer, grid);
+
+    std::int64_t changed = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        lifecycle_system(grid);
+        update_system(grid);
+        grid.each_change([&](Position, bool) { changed++; });
+        state.ResumeTiming();
+
+        update_renderer(renderer, grid);
+        target.clear(sf::Color::Black);
+        renderer.draw(target);
+        target.display();
+    }
+    state.counters["live_cells"] = static_cast<double>(grid.population());
+    state.counters["changed_cells"] = benchmark::Counter(
+        static_cast<double>(changed), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_render_frame_incremental)
+    ->Arg(100000)
+    ->Arg(500000)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,30 @@
+#include <algorithm>
+
+#include <SFML/Graphics.hpp>
+
+#include "renderer.hpp"
+
+CellRenderer::CellRenderer(int width_, int height_, int scale_)
+    : width(width_), height(height_), scale(scale_),
+      pixels(width_ * height_, dead_pixel), dirty_rows(height_, 1),
+      shown_generation(-1) {}
+
+void CellRenderer::clear() {
+    std::fill(pixels.begin(), pixels.end(), dead_pixel);
+    std::fill(dirty_rows.begin(), dirty_rows.end(), 1);
+}
+
+void CellRenderer::draw(sf::RenderTarget &target) {
+    if (texture.getSize().x == 0) {
+        texture.create(width, height);
+        sprite.setTexture(texture, true);
+        sprite.setScale(scale, scale);
+        std::fill(dirty_rows.begin(), dirty_rows.end(), 1);
+    }
+    take_dirty_rows([&](int y_begin, int y_end) {
+        texture.update(
+            reinterpret_cast<const sf::Uint8 *>(&pixels[y_begin * width]),
+            width, y_end - y_begin, 0, y_begin);
+    });
+    target.draw(sprite);
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "components.hpp"
+
+/**
+ * Cells born and cells that died since the board was last rendered, and how
+ * many generations they were collected over.
+ */
+struct CellChanges {
+    std::vector<Position> born;
+    std::vector<Position> died;
+    int generations = 0;
+};
+
+/**
+ * Draws the board as one pixel per cell in a persistent texture, scaled up
+ * to the cell size.
+ *
+ * The pixel buffer and texture are reused from frame to frame and the whole
+ * board is a single draw call, however many cells are alive. Only the rows
+ * holding cells set since the last draw are uploaded, a run of rows at a time,
+ * so patching the cells that changed costs time proportional to the change.
+ * The texture is created on the first draw, so the buffer can be filled
+ * without a graphics context.
+ */
+class CellRenderer {
+  public:
+    // Runs of changed rows closer than this are uploaded as one
+    static constexpr int merge_gap = 8;
+
+    CellRenderer(int width_, int height_, int scale_);
+    CellRenderer(const CellRenderer &) = delete;
+    CellRenderer &operator=(const CellRenderer &) = delete;
+
+    int board_width() const { return width; }
+    int board_height() const { return height; }
+
+    /**
+     * Mark every cell as dead.
+     */
+    void clear();
+
+    /**
+     * Mark a single cell as alive or dead. Positions outside the board are
+     * ignored.
+     */
+    void set(Position pos, bool alive) {
+        if (pos.x >= 0 && pos.x < width && pos.y >= 0 && pos.y < height) {
+            pixels[pos.y * width + pos.x] = alive ? live_pixel : dead_pixel;
+            dirty_rows[pos.y] = 1;
+        }
+    }
+
+    bool get(Position pos) const {
+        return pixels[pos.y * width + pos.x] == live_pixel;
+    }
+
+    /**
+     * The generation the pixels show, for worlds that count them, or -1 if
+     * nothing has been shown yet.
+     */
+    std::int64_t generation() const { return shown_generation; }
+    void set_generation(std::int64_t generation_) {
+        shown_generation = generation_;
+    }
+
+    /**
+     * Call f with the first row and one past the last row of each run of rows
+     * set since the last call, clearing the marks. Runs fewer than merge_gap
+     * rows apart are joined, as uploading a few unchanged rows costs less than
+     * another upload.
+     */
+    template <typename F> void take_dirty_rows(F f) {
+        int run_begin = -1, run_end = -1;
+        for (auto y = 0; y < height; y++) {
+            if (!dirty_rows[y]) {
+                continue;
+            }
+            dirty_rows[y] = 0;
+            if (run_begin >= 0 && y - run_end >= merge_gap) {
+                f(run_begin, run_end);
+                run_begin = -1;
+            }
+            if (run_begin < 0) {
+                run_begin = y;
+            }
+            run_end = y + 1;
+        }
+        if (run_begin >= 0) {
+            f(run_begin, run_end);
+        }
+    }
+
+    /**
+     * Upload the rows changed since the last draw and draw the board to the
+     * target.
+     */
+    void draw(sf::RenderTarget &target);
+
+  private:
+    // RGBA bytes, opaque white for live cells and transparent for dead ones
+    // so the cleared window shows through
+    static constexpr std::uint32_t live_pixel = 0xffffffff;
+    static constexpr std::uint32_t dead_pixel = 0x00000000;
+
+    int width;
+    int height;
+    int scale;
+    std::vector<std::uint32_t> pixels;
+    // Rows set since the last upload
+    std::vector<std::uint8_t> dirty_rows;
+    std::int64_t shown_generation;
+    sf::Texture texture;
+    sf::Sprite sprite;
+};
@@ -0,0 +1,82 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <doctest.h>
+
+#include "components.hpp"
+#include "renderer.hpp"
+
+// The pixel buffer and texture are reused between frames
+static_assert(!std::is_copy_constructible<CellRenderer>::value, "");
+
+TEST_SUITE("CellRenderer") {
+    TEST_CASE("cells start dead") {
+        CellRenderer renderer(8, 4, 10);
+        for (auto x = 0; x < 8; x++) {
+            for (auto y = 0; y < 4; y++) {
+                REQUIRE(!renderer.get(Position(x, y)));
+            }
+        }
+    }
+
+    TEST_CASE("set cells are alive until cleared") {
+        CellRenderer renderer(8, 4, 10);
+        renderer.set(Position(7, 3), true);
+        renderer.set(Position(0, 1), true);
+        renderer.set(Position(0, 1), false);
+
+        REQUIRE(renderer.get(Position(7, 3)));
+        REQUIRE(!renderer.get(Position(0, 1)));
+
+        renderer.clear();
+        REQUIRE(!renderer.get(Position(7, 3)));
+    }
+
+    TEST_CASE("changed rows are taken in runs") {
+        auto gap = CellRenderer::merge_gap;
+        CellRenderer renderer(8, 100, 10);
+        std::vector<std::pair<int, int>> runs;
+        auto take = [&] {
+            runs.clear();
+            renderer.take_dirty_rows([&](int y_begin, int y_end) {
+                runs.emplace_back(y_begin, y_end);
+            });
+        };
+
+        // Every row is uploaded the first time
+        take();
+        REQUIRE(runs == std::vector<std::pair<int, int>>{{0, 100}});
+        take();
+        REQUIRE(runs.empty());
+
+        renderer.set(Position(0, 2), true);
+        renderer.set(Position(3, 3), true);
+        renderer.set(Position(1, 3 + gap), true);
+        renderer.set(Position(1, 4 + 2 * gap), true);
+        renderer.set(Position(1, 90), true);
+        take();
+        REQUIRE(runs == std::vector<std::pair<int, int>>{
+                            {2, 4 + gap},
+                            {4 + 2 * gap, 5 + 2 * gap},
+                            {90, 91}});
+
+        renderer.clear();
+        take();
+        REQUIRE(runs == std::vector<std::pair<int, int>>{{0, 100}});
+    }
+
+    TEST_CASE("positions outside the board are ignored") {
+        CellRenderer renderer(8, 4, 10);
+        renderer.set(Position(8, 0), true);
+        renderer.set(Position(0, -1), true);
+
+        for (auto x = 0; x < 8; x++) {
+            for (auto y = 0; y < 4; y++) {
+                REQUIRE(!renderer.get(Position(x, y)));
+            }
+        }
+    }
+}
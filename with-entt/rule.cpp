@@ -0,0 +1,48 @@
+#include <cctype>
+#include <cstdint>
+#include <string>
+
+#include "rule.hpp"
+
+bool parse_rule(const std::string &text, Rule &rule) {
+    std::uint16_t counts[2] = {0, 0};
+    bool seen[2] = {false, false};
+    int half = -1;
+    for (auto c : text) {
+        auto upper = std::toupper(static_cast<unsigned char>(c));
+        if (upper == 'B' || upper == 'S') {
+            half = upper == 'B' ? 0 : 1;
+            if (seen[half]) {
+                return false;
+            }
+            seen[half] = true;
+        } else if (c == '/' && half != -1 && !seen[0] + !seen[1] == 1) {
+            half = -1;
+        } else if (c >= '0' && c <= '8' && half != -1) {
+            counts[half] |= std::uint16_t(1 << (c - '0'));
+        } else {
+            return false;
+        }
+    }
+    if (!seen[0] || !seen[1] || (counts[0] & 1)) {
+        return false;
+    }
+    rule = Rule(counts[0], counts[1]);
+    return true;
+}
+
+std::string rule_name(Rule rule) {
+    std::string name = "B";
+    for (auto n = 0; n <= 8; n++) {
+        if (rule.birth() & (1 << n)) {
+            name += char('0' + n);
+        }
+    }
+    name += "/S";
+    for (auto n = 0; n <= 8; n++) {
+        if (rule.survival() & (1 << n)) {
+            name += char('0' + n);
+        }
+    }
+    return name;
+}
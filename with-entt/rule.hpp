@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+/**
+ * A Life-like rule in B/S notation, the neighbour counts a dead cell is born
+ * with and the counts a live cell survives with.
+ *
+ * Both are packed into one mask, bit n for a birth with n neighbours and bit
+ * 16 + n for surviving with n, so the next state of a cell is a single shift
+ * and mask with no branches.
+ */
+struct Rule {
+    std::uint32_t mask;
+
+    constexpr Rule(std::uint16_t birth_, std::uint16_t survival_)
+        : mask(std::uint32_t(survival_) << 16 | birth_) {}
+
+    constexpr std::uint16_t birth() const { return mask & 0xffff; }
+    constexpr std::uint16_t survival() const { return mask >> 16; }
+
+    /**
+     * Whether a cell is alive next generation.
+     */
+    constexpr bool next(bool alive, int neighbour_count) const {
+        return (mask >> (neighbour_count + (int(alive) << 4))) & 1;
+    }
+
+    constexpr bool operator==(Rule other) const { return mask == other.mask; }
+    constexpr bool operator!=(Rule other) const { return mask != other.mask; }
+};
+
+/**
+ * A rule fixed at compile time, so code instantiated with it has the rule's
+ * counts folded in.
+ */
+template <std::uint32_t Mask> struct FixedRule {
+    static constexpr Rule rule = Rule(Mask & 0xffff, Mask >> 16);
+
+    constexpr bool next(bool alive, int neighbour_count) const {
+        return (Mask >> (neighbour_count + (int(alive) << 4))) & 1;
+    }
+};
+
+constexpr std::uint16_t neighbour_counts(std::initializer_list<int> counts) {
+    std::uint16_t bits = 0;
+    for (auto count : counts) {
+        bits |= std::uint16_t(1 << count);
+    }
+    return bits;
+}
+
+// B3/S23
+constexpr Rule conway_rule(neighbour_counts({3}), neighbour_counts({2, 3}));
+// B36/S23
+constexpr Rule highlife_rule(neighbour_counts({3, 6}),
+                             neighbour_counts({2, 3}));
+// B2/S
+constexpr Rule seeds_rule(neighbour_counts({2}), 0);
+// B3678/S34678
+constexpr Rule day_and_night_rule(neighbour_counts({3, 6, 7, 8}),
+                                  neighbour_counts({3, 4, 6, 7, 8}));
+
+/**
+ * Parse a rule in B/S notation, such as "B36/S23", into rule. The B and S
+ * halves can come in either order and are case insensitive.
+ *
+ * Returns false if the text isn't a rule, or if it has cells born with no
+ * neighbours, which would fill the unbounded empty space around the board.
+ */
+bool parse_rule(const std::string &text, Rule &rule);
+
+/**
+ * The rule in B/S notation.
+ */
+std::string rule_name(Rule rule);
+
+/**
+ * Call f with the rule as a FixedRule if it is one of the common rules that
+ * have code instantiated for them, or as the Rule itself otherwise. f must
+ * accept both and return the same type for each.
+ */
+template <typename F> auto with_rule(Rule rule, F f) {
+    // Compares masks rather than calling Rule's members, as this is also
+    // instantiated in the AVX2 kernel's translation unit
+    if (rule.mask == conway_rule.mask) {
+        return f(FixedRule<conway_rule.mask>());
+    } else if (rule.mask == highlife_rule.mask) {
+        return f(FixedRule<highlife_rule.mask>());
+    } else if (rule.mask == seeds_rule.mask) {
+        return f(FixedRule<seeds_rule.mask>());
+    } else if (rule.mask == day_and_night_rule.mask) {
+        return f(FixedRule<day_and_night_rule.mask>());
+    }
+    return f(rule);
+}
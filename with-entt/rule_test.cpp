@@ -0,0 +1,70 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <string>
+#include <type_traits>
+
+#include <doctest.h>
+
+#include "rule.hpp"
+
+TEST_SUITE("Rule") {
+    TEST_CASE("B3/S23 is Conway's Game of Life") {
+        for (auto n = 0; n <= 8; n++) {
+            CAPTURE(n);
+            REQUIRE(conway_rule.next(false, n) == (n == 3));
+            REQUIRE(conway_rule.next(true, n) == (n == 2 || n == 3));
+        }
+    }
+
+    TEST_CASE("fixed rules agree with their runtime rule") {
+        FixedRule<highlife_rule.mask> highlife;
+        for (auto n = 0; n <= 8; n++) {
+            REQUIRE(highlife.next(false, n) == highlife_rule.next(false, n));
+            REQUIRE(highlife.next(true, n) == highlife_rule.next(true, n));
+        }
+        REQUIRE(FixedRule<seeds_rule.mask>::rule == seeds_rule);
+    }
+
+    TEST_CASE("rules are parsed from B/S notation") {
+        Rule rule = conway_rule;
+        REQUIRE(parse_rule("B36/S23", rule));
+        REQUIRE(rule == highlife_rule);
+        REQUIRE(parse_rule("b2/s", rule));
+        REQUIRE(rule == seeds_rule);
+        REQUIRE(parse_rule("S34678/B3678", rule));
+        REQUIRE(rule == day_and_night_rule);
+        REQUIRE(parse_rule("B3/S23", rule));
+        REQUIRE(rule == conway_rule);
+    }
+
+    TEST_CASE("anything else is rejected") {
+        Rule rule = highlife_rule;
+        for (std::string text :
+             {"", "23/3", "B3", "B3/S23/", "B39/S23", "B3/B3", "B3/S2x",
+              "/B3S23", "B03/S23"}) {
+            CAPTURE(text);
+            REQUIRE_FALSE(parse_rule(text, rule));
+        }
+        REQUIRE(rule == highlife_rule);
+    }
+
+    TEST_CASE("names round trip through the parser") {
+        for (auto rule :
+             {conway_rule, highlife_rule, seeds_rule, day_and_night_rule}) {
+            Rule parsed = conway_rule;
+            REQUIRE(parse_rule(rule_name(rule), parsed));
+            REQUIRE(parsed == rule);
+        }
+        REQUIRE(rule_name(highlife_rule) == "B36/S23");
+        REQUIRE(rule_name(seeds_rule) == "B2/S");
+    }
+
+    TEST_CASE("common rules are dispatched to their fixed rule") {
+        auto fixed = [](auto rule) {
+            return !std::is_same<decltype(rule), Rule>::value;
+        };
+        REQUIRE(with_rule(conway_rule, fixed));
+        REQUIRE(with_rule(day_and_night_rule, fixed));
+        REQUIRE_FALSE(with_rule(Rule(1 << 3, 1 << 5), fixed));
+    }
+}
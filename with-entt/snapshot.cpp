@@ -0,0 +1,22 @@
+#include <atomic>
+
+#include "snapshot.hpp"
+
+SnapshotBuffer::SnapshotBuffer()
+    : back_index(0), front_index(1), shared_index(2) {}
+
+void SnapshotBuffer::publish() {
+    back_index = shared_index.exchange(back_index | fresh,
+                                       std::memory_order_acq_rel) &
+                 ~fresh;
+}
+
+bool SnapshotBuffer::acquire() {
+    if (!(shared_index.load(std::memory_order_relaxed) & fresh)) {
+        return false;
+    }
+    front_index = shared_index.exchange(front_index,
+                                        std::memory_order_acq_rel) &
+                  ~fresh;
+    return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "components.hpp"
+
+/**
+ * The live cells of one generation, as published for rendering.
+ */
+struct Snapshot {
+    std::int64_t generation = -1;
+    std::vector<Position> live;
+};
+
+/**
+ * Lock-free triple buffer handing snapshots from the thread computing
+ * generations to the thread rendering them.
+ *
+ * The producer fills back() and publishes it, the consumer picks up the most
+ * recently published snapshot with acquire() and reads it through front().
+ * Neither side ever waits on the other: the producer always has a slot to
+ * write to and the consumer skips snapshots it was too slow to see. Only one
+ * thread may produce and only one may consume.
+ */
+class SnapshotBuffer {
+  public:
+    SnapshotBuffer();
+    SnapshotBuffer(const SnapshotBuffer &) = delete;
+    SnapshotBuffer &operator=(const SnapshotBuffer &) = delete;
+
+    /**
+     * The slot the producer fills next. It isn't read by the consumer until
+     * it is published.
+     */
+    Snapshot &back() { return slots[back_index].snapshot; }
+
+    /**
+     * Make the back slot the latest snapshot and take a new back slot.
+     */
+    void publish();
+
+    /**
+     * Move front() on to the latest published snapshot, returning false if
+     * nothing has been published since the last call.
+     */
+    bool acquire();
+
+    /**
+     * The snapshot the consumer last acquired.
+     */
+    const Snapshot &front() const { return slots[front_index].snapshot; }
+
+  private:
+    // Set in the shared index while it holds a snapshot not yet acquired
+    static const int fresh = 4;
+
+    // Kept on separate cache lines so the two threads don't contend on them
+    struct alignas(64) Slot {
+        Snapshot snapshot;
+    };
+
+    std::array<Slot, 3> slots;
+    int back_index;
+    int front_index;
+    alignas(64) std::atomic<int> shared_index;
+};
@@ -0,0 +1,80 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <doctest.h>
+
+#include "components.hpp"
+#include "snapshot.hpp"
+
+TEST_SUITE("SnapshotBuffer") {
+    TEST_CASE("nothing is acquired before a publish") {
+        SnapshotBuffer buffer;
+        REQUIRE_FALSE(buffer.acquire());
+    }
+
+    TEST_CASE("the latest published snapshot is acquired once") {
+        SnapshotBuffer buffer;
+        buffer.back().generation = 1;
+        buffer.publish();
+        buffer.back().generation = 2;
+        buffer.publish();
+
+        REQUIRE(buffer.acquire());
+        REQUIRE(buffer.front().generation == 2);
+        REQUIRE_FALSE(buffer.acquire());
+        REQUIRE(buffer.front().generation == 2);
+    }
+
+    TEST_CASE("the producer never writes to the acquired snapshot") {
+        SnapshotBuffer buffer;
+        buffer.back().generation = 1;
+        buffer.publish();
+        REQUIRE(buffer.acquire());
+
+        for (auto generation = 2; generation < 10; generation++) {
+            buffer.back().generation = generation;
+            buffer.publish();
+            REQUIRE(buffer.front().generation == 1);
+        }
+    }
+
+    TEST_CASE("snapshots handed between threads are whole and in order") {
+        SnapshotBuffer buffer;
+        const int generations = 20000;
+        std::atomic<bool> done(false);
+
+        std::thread producer([&] {
+            for (auto generation = 0; generation < generations; generation++) {
+                auto &snapshot = buffer.back();
+                snapshot.generation = generation;
+                snapshot.live.assign(generation % 64,
+                                     Position(generation, generation));
+                buffer.publish();
+            }
+            done = true;
+        });
+
+        std::int64_t last = -1;
+        auto finished = false;
+        while (!finished) {
+            finished = done.load();
+            if (buffer.acquire()) {
+                auto &snapshot = buffer.front();
+                REQUIRE(snapshot.generation > last);
+                last = snapshot.generation;
+                REQUIRE(static_cast<std::int64_t>(snapshot.live.size()) ==
+                        last % 64);
+                for (auto &pos : snapshot.live) {
+                    REQUIRE(pos == Position(last, last));
+                }
+            }
+        }
+        producer.join();
+
+        REQUIRE(last == generations - 1);
+    }
+}
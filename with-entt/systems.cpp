@@ -1,12 +1,29 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
 #include <random>
 #include <unordered_set>
+#include <vector>
 
 #include <SFML/Graphics.hpp>
 #include <entt/entt.hpp>
 
+#include "bitgrid.hpp"
+#include "checkpoint.hpp"
 #include "components.hpp"
+#include "grid.hpp"
+#include "hashlife.hpp"
+#include "instrument.hpp"
 #include "log.hpp"
-#include "utils.hpp"
+#include "pattern.hpp"
+#include "position_map.hpp"
+#include "random.hpp"
+#include "renderer.hpp"
+#include "rule.hpp"
+#include "snapshot.hpp"
+#include "systems.hpp"
+#include "thread_pool.hpp"
 
 template <typename T>
 std::ostream &operator<<(std::ostream &stream, const std::vector<T> &in) {
@@ -33,93 +50,507 @@ std::ostream &operator<<(std::ostream &stream,
 }
 
 /**
- * Initialise the registry with live cells.
+ * Whether every cell of an arena can be numbered with an int, as the dense
+ * registry and the random starting cells are.
  */
-void initialise_registry(entt::registry &registry, int n_alive_cells,
+bool arena_fits_index(int arena_x_max, int arena_y_max) {
+    return arena_x_max >= 0 && arena_y_max >= 0 &&
+           std::int64_t(arena_x_max) * arena_y_max <=
+               std::numeric_limits<int>::max();
+}
+
+/**
+ * Pick n_chosen distinct cell indices in [0, n_cells), in time linear in the
+ * number of cells.
+ */
+template <typename RandGen>
+static std::vector<int> sample_cells(int n_cells, int n_chosen,
+                                     RandGen &rand_gen) {
+    std::vector<int> cells(n_cells);
+    std::iota(cells.begin(), cells.end(), 0);
+    n_chosen = std::min(n_chosen, n_cells);
+
+    // Partial Fisher-Yates shuffle, the first n_chosen cells are the sample
+    for (auto i = 0; i < n_chosen; i++) {
+        std::uniform_int_distribution<> dist(i, n_cells - 1);
+        std::swap(cells[i], cells[dist(rand_gen)]);
+    }
+    cells.resize(n_chosen);
+    return cells;
+}
+
+/**
+ * Initialise the registry with live cells, from a fresh random seed.
+ */
+bool initialise_registry(entt::registry &registry, int n_alive_cells,
                          int arena_x_max, int arena_y_max) {
-    std::unordered_set<Position> positions;
+    RandGen rand_gen(random_seed());
+    return initialise_registry(registry, n_alive_cells, arena_x_max,
+                               arena_y_max, rand_gen);
+}
 
-    // Build up the collection of possible possitions
+/**
+ * Create an entity for every position in the arena, tagging the ones marked
+ * alive, indexed x * arena_y_max + y.
+ */
+static void create_arena(entt::registry &registry,
+                         const std::vector<std::uint8_t> &alive,
+                         int arena_x_max, int arena_y_max) {
     for (auto x = 0; x < arena_x_max; x++) {
         for (auto y = 0; y < arena_y_max; y++) {
-            positions.emplace(x, y);
+            auto entity = registry.create();
+            registry.assign<Position>(entity, x, y);
+            if (alive[x * arena_y_max + y]) {
+                registry.assign<entt::tag<"is_alive"_hs>>(entity);
+            }
         }
     }
 
+    // Size the live grid up front rather than in the first round
+    live_grid(registry).rebuild(registry);
+}
+
+/**
+ * Initialise the registry with live cells. Returns false, leaving the
+ * registry empty, if the arena is too big to number its cells.
+ */
+bool initialise_registry(entt::registry &registry, int n_alive_cells,
+                         int arena_x_max, int arena_y_max, RandGen &rand_gen) {
+    if (!arena_fits_index(arena_x_max, arena_y_max)) {
+        return false;
+    }
+
     // Randomly select the live cell positions, without replacement
-    for (auto i = 0; i < n_alive_cells; i++) {
-        auto pos = rand_choice(positions.begin(), positions.end());
-        auto entity = registry.create();
-        registry.assign<Position>(entity, *pos);
-        registry.assign<entt::tag<"is_alive"_hs>>(entity);
-        positions.erase(pos);
+    auto n_cells = arena_x_max * arena_y_max;
+    std::vector<std::uint8_t> alive(n_cells, 0);
+    for (auto cell : sample_cells(n_cells, n_alive_cells, rand_gen)) {
+        alive[cell] = 1;
     }
+    create_arena(registry, alive, arena_x_max, arena_y_max);
+    return true;
+}
+
+/**
+ * Where to put a pattern's origin so the pattern is centred in the arena.
+ * Patterns without a size are centred on their own origin.
+ */
+static void pattern_origin(const PatternFile &pattern, int arena_x_max,
+                           int arena_y_max, std::int64_t &x, std::int64_t &y) {
+    x = (arena_x_max - pattern.width()) / 2;
+    y = (arena_y_max - pattern.height()) / 2;
+}
 
-    for (auto pos : positions) {
-        auto entity = registry.create();
-        registry.assign<Position>(entity, pos);
+/**
+ * Create the arena with the live cells read from a pattern or checkpoint,
+ * moved to x, y. Cells outside of the arena are dropped. An arena too big to
+ * number its cells is rejected before anything is read.
+ */
+template <typename Cells>
+static bool read_registry(entt::registry &registry, const Cells &source,
+                          std::int64_t x, std::int64_t y, int arena_x_max,
+                          int arena_y_max) {
+    if (!arena_fits_index(arena_x_max, arena_y_max)) {
+        return false;
     }
+    std::vector<std::uint8_t> alive(arena_x_max * arena_y_max, 0);
+    auto loaded = source.read(
+        x, y,
+        [&](const Position *cells, std::size_t n_cells) {
+            for (auto cell = cells; cell != cells + n_cells; cell++) {
+                alive[cell->x * arena_y_max + cell->y] = 1;
+            }
+        },
+        CellBox{0, 0, arena_x_max, arena_y_max});
+    create_arena(registry, alive, arena_x_max, arena_y_max);
+    return loaded;
 }
 
 /**
- * Run the Game of Life lifecycle.
+ * Initialise the registry with the live cells of a pattern, centred in the
+ * arena. Cells outside of the arena are dropped. Returns false if the
+ * pattern is malformed.
  */
-void lifecycle_system(entt::registry &registry) {
-    std::unordered_set<Position> alive_cells;
+bool load_registry(entt::registry &registry, const PatternFile &pattern,
+                   int arena_x_max, int arena_y_max) {
+    std::int64_t x, y;
+    pattern_origin(pattern, arena_x_max, arena_y_max, x, y);
+    return read_registry(registry, pattern, x, y, arena_x_max, arena_y_max);
+}
 
-    // Find and set currently alive cells that will be alive in the next round
-    registry.view<Position, entt::tag<"is_alive"_hs>>().each(
-        [&](auto entity, auto &pos, auto _) mutable {
-            int neighbour_count = 0;
-            auto view = registry.view<Position, entt::tag<"is_alive"_hs>>();
-            for (auto entity : view) {
-                auto their_pos = registry.get<Position>(entity);
-                if (pos != their_pos && is_neighbour(pos, their_pos)) {
-                    neighbour_count += 1;
+/**
+ * Initialise the registry with the arena and live cells of a checkpoint.
+ * Returns false if the checkpoint is malformed.
+ */
+bool restore_registry(entt::registry &registry,
+                      const CheckpointFile &checkpoint) {
+    return read_registry(registry, checkpoint, 0, 0, checkpoint.width(),
+                         checkpoint.height());
+}
+
+/**
+ * Add an entity for each live cell read from a pattern or checkpoint, moved
+ * to x, y, to a registry in sparse mode. Cells outside of the arena are
+ * dropped.
+ */
+template <typename Cells>
+static bool read_sparse_registry(entt::registry &registry,
+                                 const Cells &source, std::int64_t x,
+                                 std::int64_t y, int arena_x_max,
+                                 int arena_y_max) {
+    registry.set<SparseGrid>(arena_x_max, arena_y_max);
+
+    // Life 1.06 files can list a cell more than once
+    PositionSet positions;
+    return source.read(
+        x, y,
+        [&](const Position *cells, std::size_t n_cells) {
+            for (auto cell = cells; cell != cells + n_cells; cell++) {
+                if (positions.insert(*cell)) {
+                    auto entity = registry.create();
+                    registry.assign<Position>(entity, *cell);
+                    registry.assign<entt::tag<"is_alive"_hs>>(entity);
                 }
             }
-            if (neighbour_count == 2 || neighbour_count == 3) {
+        },
+        CellBox{0, 0, arena_x_max, arena_y_max});
+}
+
+/**
+ * Initialise the registry in sparse mode with the live cells of a pattern,
+ * centred in the arena. Cells outside of the arena are dropped. Returns false
+ * if the pattern is malformed.
+ */
+bool load_sparse_registry(entt::registry &registry,
+                          const PatternFile &pattern, int arena_x_max,
+                          int arena_y_max) {
+    std::int64_t x, y;
+    pattern_origin(pattern, arena_x_max, arena_y_max, x, y);
+    return read_sparse_registry(registry, pattern, x, y, arena_x_max,
+                                arena_y_max);
+}
+
+/**
+ * Initialise the registry in sparse mode with the arena and live cells of a
+ * checkpoint. Returns false if the checkpoint is malformed.
+ */
+bool restore_sparse_registry(entt::registry &registry,
+                             const CheckpointFile &checkpoint) {
+    return read_sparse_registry(registry, checkpoint, 0, 0,
+                                checkpoint.width(), checkpoint.height());
+}
+
+/**
+ * Initialise the registry in sparse mode from a fresh random seed.
+ */
+void initialise_sparse_registry(entt::registry &registry, int n_alive_cells,
+                                int arena_x_max, int arena_y_max) {
+    RandGen rand_gen(random_seed());
+    initialise_sparse_registry(registry, n_alive_cells, arena_x_max,
+                               arena_y_max, rand_gen);
+}
+
+/**
+ * Initialise the registry in sparse mode, where only live cells are entities.
+ */
+void initialise_sparse_registry(entt::registry &registry, int n_alive_cells,
+                                int arena_x_max, int arena_y_max,
+                                RandGen &rand_gen) {
+    registry.set<SparseGrid>(arena_x_max, arena_y_max);
+
+    n_alive_cells = static_cast<int>(std::min<std::int64_t>(
+        n_alive_cells, std::int64_t(arena_x_max) * arena_y_max));
+
+    // Rejection sample the live cell positions, which stays proportional to
+    // the number of live cells while the arena is sparsely populated
+    std::uniform_int_distribution<> x_dist(0, arena_x_max - 1);
+    std::uniform_int_distribution<> y_dist(0, arena_y_max - 1);
+    PositionSet positions(n_alive_cells);
+    while (static_cast<int>(positions.size()) < n_alive_cells) {
+        Position pos(x_dist(rand_gen), y_dist(rand_gen));
+        if (positions.insert(pos)) {
+            auto entity = registry.create();
+            registry.assign<Position>(entity, pos);
+            registry.assign<entt::tag<"is_alive"_hs>>(entity);
+        }
+    }
+}
+
+/**
+ * Cells found to be alive in the next round, one buffer per worker so the
+ * tiles can be processed in parallel.
+ */
+struct AliveNext {
+    // Kept on separate cache lines so workers don't contend on them
+    struct alignas(64) Cells {
+        std::vector<entt::entity> cells;
+    };
+    std::vector<Cells> per_worker;
+};
+
+/**
+ * The rule set in the registry's context, or B3/S23 if there isn't one.
+ */
+static Rule registry_rule(entt::registry &registry) {
+    auto rule = registry.try_ctx<Rule>();
+    return rule ? *rule : conway_rule;
+}
+
+/**
+ * Tag the currently alive cells that will be alive in the next round.
+ */
+template <typename Grid, typename RuleT>
+static void survival_pass(entt::registry &registry, const Grid &grid,
+                          const RuleT &rule) {
+    registry.view<Position, entt::tag<"is_alive"_hs>>().each(
+        [&](auto entity, auto &pos, auto _) {
+            if (rule.next(true, grid.count_neighbours(pos))) {
                 registry.assign<entt::tag<"is_alive_next"_hs>>(entity);
             }
-            alive_cells.emplace(pos.x, pos.y);
         });
+}
 
-    // Determine and create cells that will be alive next round but currently
-    // don't exist. This uses the position map built up whilst setting the
-    // currently alive cells that will be alive next round.
-    registry.view<Position>(entt::exclude<entt::tag<"is_alive"_hs>>)
-        .each([&, alive_cells](auto entity, auto &pos) {
-            auto possible_neighbours = find_possible_neighbours(pos);
-            int neighbour_count = std::count_if(
-                possible_neighbours.begin(), possible_neighbours.end(),
-                [alive_cells](auto pos) {
-                    auto res = alive_cells.find(pos) != alive_cells.end();
-                    if (res) {
-                    }
-                    return res;
-                });
-            if (neighbour_count == 3 &&
-                !registry.has<entt::tag<"is_alive"_hs>>(entity)) {
-                registry.assign<entt::tag<"is_alive_next"_hs>>(entity);
+template <typename RuleT>
+static void lifecycle_system(entt::registry &registry, const RuleT &rule) {
+    if (auto sparse = registry.try_ctx<SparseGrid>()) {
+        sparse->rebuild(registry);
+        survival_pass(registry, *sparse, rule);
+
+        // Only live cells exist, so cells born next round are created here
+        sparse->each_birth(rule, [&](Position pos) {
+            auto entity = registry.create();
+            registry.assign<Position>(entity, pos);
+            registry.assign<entt::tag<"is_alive_next"_hs>>(entity);
+        });
+        return;
+    }
+
+    auto &grid = live_grid(registry);
+    grid.rebuild(registry);
+
+    auto pool = registry.try_ctx<ThreadPool>();
+    auto alive_next = registry.try_ctx<AliveNext>();
+    if (!alive_next) {
+        alive_next = &registry.set<AliveNext>();
+    }
+    alive_next->per_worker.resize(pool ? pool->size() : 1);
+
+    // Find the cells alive in the next round, tile by tile. Each worker only
+    // reads the grid and writes its own buffer.
+    auto lifecycle_tile = [&](int tile, int worker) {
+        auto &cells = alive_next->per_worker[worker].cells;
+        grid.each_in_tile(tile, [&](auto entity, bool alive,
+                                    int neighbour_count) {
+            if (rule.next(alive, neighbour_count)) {
+                cells.push_back(entity);
             }
         });
+    };
+    if (pool) {
+        pool->run(grid.tile_count(), lifecycle_tile);
+    } else {
+        for (auto tile = 0; tile < grid.tile_count(); tile++) {
+            lifecycle_tile(tile, 0);
+        }
+    }
+
+    // Merge the workers' results into the registry
+    for (auto &worker : alive_next->per_worker) {
+        for (auto entity : worker.cells) {
+            registry.assign<entt::tag<"is_alive_next"_hs>>(entity);
+        }
+        worker.cells.clear();
+    }
 }
 
 /**
- * Render the current state.
+ * Run the Game of Life lifecycle, with the rule set in the registry's context
+ * if there is one.
  */
-void render_system(sf::RenderWindow &window, int scale,
-                   entt::registry &registry) {
-    window.clear(sf::Color::Black);
+void lifecycle_system(entt::registry &registry) {
+    GOL_TIME("lifecycle_system");
+    with_rule(registry_rule(registry),
+              [&](auto rule) { lifecycle_system(registry, rule); });
+}
 
-    registry.group<Position>(entt::get<entt::tag<"is_alive"_hs>>)
-        .each([&](auto &pos, auto _) {
-            sf::RectangleShape cell(
-                sf::Vector2f(1.0f * (scale - 0.5f), 1.0f * (scale - 0.5f)));
-            cell.setPosition(pos.x * scale, pos.y * scale);
-            window.draw(cell);
+/**
+ * Cells changing state in the next round, one buffer per worker so the tiles
+ * can be processed in parallel.
+ */
+struct CellFlips {
+    // Kept on separate cache lines so workers don't contend on them
+    struct alignas(64) Cells {
+        std::vector<entt::entity> born;
+        std::vector<entt::entity> died;
+    };
+    std::vector<Cells> per_worker;
+};
+
+/**
+ * Apply the cells born and died to the is_alive tags, and to the live grid if
+ * there is one, recording them for the renderer if it is tracking changes.
+ */
+static void apply_flips(entt::registry &registry, CellFlips::Cells &cells,
+                        LiveGrid *grid, CellChanges *changes) {
+    for (auto entity : cells.died) {
+        auto &pos = registry.get<Position>(entity);
+        if (grid) {
+            grid->set_alive(pos, false);
+        }
+        if (changes) {
+            changes->died.push_back(pos);
+        }
+        registry.remove<entt::tag<"is_alive"_hs>>(entity);
+    }
+    for (auto entity : cells.born) {
+        auto &pos = registry.get<Position>(entity);
+        if (grid) {
+            grid->set_alive(pos, true);
+        }
+        if (changes) {
+            changes->born.push_back(pos);
+        }
+        registry.assign<entt::tag<"is_alive"_hs>>(entity);
+    }
+    cells.died.clear();
+    cells.born.clear();
+}
+
+template <typename RuleT>
+static void step_system(entt::registry &registry, const RuleT &rule) {
+    auto flips = registry.try_ctx<CellFlips>();
+    if (!flips) {
+        flips = &registry.set<CellFlips>();
+    }
+    auto changes = registry.try_ctx<CellChanges>();
+
+    if (auto sparse = registry.try_ctx<SparseGrid>()) {
+        flips->per_worker.resize(1);
+        auto &cells = flips->per_worker[0];
+        sparse->rebuild(registry);
+        registry.view<Position, entt::tag<"is_alive"_hs>>().each(
+            [&](auto entity, auto &pos, auto _) {
+                if (!rule.next(true, sparse->count_neighbours(pos))) {
+                    cells.died.push_back(entity);
+                }
+            });
+
+        // Only live cells exist, so cells are created on birth and destroyed
+        // on death
+        sparse->each_birth(rule, [&](Position pos) {
+            auto entity = registry.create();
+            registry.assign<Position>(entity, pos);
+            cells.born.push_back(entity);
+        });
+        for (auto entity : cells.died) {
+            if (changes) {
+                changes->died.push_back(registry.get<Position>(entity));
+            }
+            registry.destroy(entity);
+        }
+        cells.died.clear();
+        apply_flips(registry, cells, nullptr, changes);
+        return;
+    }
+
+    auto &grid = live_grid(registry);
+    if (!grid.in_sync(registry)) {
+        grid.rebuild(registry);
+    }
+    auto &tiles = grid.take_active_tiles();
+    LOG_DEBUG("Stepping " << tiles.size() << " of " << grid.tile_count()
+                          << " tiles");
+
+    auto pool = registry.try_ctx<ThreadPool>();
+    flips->per_worker.resize(pool ? pool->size() : 1);
+
+    // Find the cells that change, tile by tile. Each worker only reads the
+    // grid and writes its own buffers.
+    auto step_tile = [&](int active_tile, int worker) {
+        auto tile = tiles[active_tile];
+        auto &cells = flips->per_worker[worker];
+        grid.each_in_tile(tile, [&](auto entity, bool alive,
+                                    int neighbour_count) {
+            bool alive_next = rule.next(alive, neighbour_count);
+            if (alive_next != alive) {
+                (alive_next ? cells.born : cells.died).push_back(entity);
+            }
         });
+    };
+    auto n_tiles = static_cast<int>(tiles.size());
+    if (pool) {
+        pool->run(n_tiles, step_tile);
+    } else {
+        for (auto tile = 0; tile < n_tiles; tile++) {
+            step_tile(tile, 0);
+        }
+    }
+
+    for (auto &cells : flips->per_worker) {
+        apply_flips(registry, cells, &grid, changes);
+    }
+}
+
+/**
+ * Advance the registry a whole generation in one pass, the same as running
+ * the lifecycle, cleanup and update systems.
+ *
+ * The current generation is read from the grid's snapshot of the is_alive
+ * tags and only the cells that change have their tag added or removed, so
+ * there is no is_alive_next churn and cells that stay alive or dead aren't
+ * touched. The grid is kept up to date with the changes rather than rebuilt,
+ * and only the tiles around the last round's changes are visited. Like the
+ * lifecycle system, it steps with the rule in the registry's context if
+ * there is one.
+ */
+void step_system(entt::registry &registry) {
+    GOL_TIME("step_system");
+    with_rule(registry_rule(registry),
+              [&](auto rule) { step_system(registry, rule); });
+    if (auto changes = registry.try_ctx<CellChanges>()) {
+        changes->generations++;
+    }
+}
+
+/**
+ * Bring the renderer's pixels up to date with the live cells.
+ *
+ * The first time every live cell is drawn and the registry starts recording
+ * CellChanges, after that only the cells born and died since are patched.
+ * Changes collected over several generations don't say which came last, so
+ * then every live cell is drawn again.
+ */
+void update_renderer(CellRenderer &renderer, entt::registry &registry) {
+    auto changes = registry.try_ctx<CellChanges>();
+    if (changes && changes->generations <= 1) {
+        for (auto pos : changes->died) {
+            renderer.set(pos, false);
+        }
+        for (auto pos : changes->born) {
+            renderer.set(pos, true);
+        }
+    } else {
+        renderer.clear();
+        registry.group<Position>(entt::get<entt::tag<"is_alive"_hs>>)
+            .each([&](auto &pos, auto _) { renderer.set(pos, true); });
+        if (!changes) {
+            changes = &registry.set<CellChanges>();
+        }
+    }
+    changes->died.clear();
+    changes->born.clear();
+    changes->generations = 0;
+}
 
+/**
+ * Render the current state.
+ */
+void render_system(sf::RenderWindow &window, CellRenderer &renderer,
+                   entt::registry &registry) {
+    GOL_TIME("render_system");
+    update_renderer(renderer, registry);
+
+    window.clear(sf::Color::Black);
+    renderer.draw(window);
     window.display();
 }
 
@@ -127,22 +558,320 @@ void render_system(sf::RenderWindow &window, int scale,
  * Remove the is_alive tag from entities that are not alive in the next round.
  */
 void cleanup_system(entt::registry &registry) {
+    GOL_TIME("cleanup_system");
+    if (auto grid = registry.try_ctx<LiveGrid>()) {
+        grid->invalidate();
+    }
+    auto changes = registry.try_ctx<CellChanges>();
     registry
         .group<entt::tag<"is_alive"_hs>>(
             entt::exclude<entt::tag<"is_alive_next"_hs>>)
         .each([&](auto entity, auto _) {
+            if (changes) {
+                changes->died.push_back(registry.get<Position>(entity));
+            }
             registry.remove<entt::tag<"is_alive"_hs>>(entity);
         });
 }
 
 /**
  * Ensure entities that have the is_alive_next tag, now have the is_alive tag
- * and the is_alive_next is removed.
+ * and the is_alive_next is removed. In sparse mode the cells that died are
+ * destroyed.
  */
 void update_system(entt::registry &registry) {
+    GOL_TIME("update_system");
+    if (auto grid = registry.try_ctx<LiveGrid>()) {
+        grid->invalidate();
+    }
+    auto changes = registry.try_ctx<CellChanges>();
     registry.view<entt::tag<"is_alive_next"_hs>>().each(
         [&](auto entity, auto _) {
+            if (changes && !registry.has<entt::tag<"is_alive"_hs>>(entity)) {
+                changes->born.push_back(registry.get<Position>(entity));
+            }
             registry.assign_or_replace<entt::tag<"is_alive"_hs>>(entity);
             registry.remove<entt::tag<"is_alive_next"_hs>>(entity);
         });
+    if (changes) {
+        changes->generations++;
+    }
+
+    if (registry.try_ctx<SparseGrid>()) {
+        registry.view<Position>(entt::exclude<entt::tag<"is_alive"_hs>>)
+            .each([&](auto entity, auto &_) { registry.destroy(entity); });
+    }
+}
+
+/**
+ * Copy the positions of the live cells into the snapshot, reusing its buffer.
+ */
+void snapshot_system(entt::registry &registry, Snapshot &snapshot) {
+    GOL_TIME("snapshot_system");
+    snapshot.live.clear();
+    registry.view<Position, entt::tag<"is_alive"_hs>>().each(
+        [&](auto &pos, auto _) { snapshot.live.push_back(pos); });
+}
+
+/**
+ * Initialise the grid with live cells at random positions, from a fresh
+ * random seed.
+ */
+void initialise_grid(BitGrid &grid, int n_alive_cells) {
+    RandGen rand_gen(random_seed());
+    initialise_grid(grid, n_alive_cells, rand_gen);
+}
+
+/**
+ * Initialise the grid with live cells at random positions.
+ */
+void initialise_grid(BitGrid &grid, int n_alive_cells, RandGen &rand_gen) {
+    for (auto cell : sample_cells(grid.width() * grid.height(), n_alive_cells,
+                                  rand_gen)) {
+        grid.set(cell % grid.width(), cell / grid.width(), true);
+    }
+}
+
+/**
+ * Set the live cells read from a pattern or checkpoint, moved to x, y, on
+ * the grid. Cells outside of the grid are dropped.
+ */
+template <typename Cells>
+static bool read_grid(BitGrid &grid, const Cells &source, std::int64_t x,
+                      std::int64_t y) {
+    return source.read(
+        x, y,
+        [&](const Position *cells, std::size_t n_cells) {
+            for (auto cell = cells; cell != cells + n_cells; cell++) {
+                grid.set(cell->x, cell->y, true);
+            }
+        },
+        CellBox{0, 0, grid.width(), grid.height()});
+}
+
+/**
+ * Initialise the grid with the live cells of a pattern, centred on it. Cells
+ * outside of the grid are dropped. Returns false if the pattern is
+ * malformed.
+ */
+bool load_grid(BitGrid &grid, const PatternFile &pattern) {
+    std::int64_t x, y;
+    pattern_origin(pattern, grid.width(), grid.height(), x, y);
+    return read_grid(grid, pattern, x, y);
+}
+
+/**
+ * Initialise the grid, which should be the size of the checkpoint's arena,
+ * with the live cells of a checkpoint. Returns false if the checkpoint is
+ * malformed.
+ */
+bool restore_grid(BitGrid &grid, const CheckpointFile &checkpoint) {
+    return read_grid(grid, checkpoint, 0, 0);
+}
+
+/**
+ * Compute the next generation of the grid into its back buffer.
+ */
+void lifecycle_system(BitGrid &grid) {
+    GOL_TIME("lifecycle_system");
+    grid.step();
+}
+
+/**
+ * Bring the renderer's pixels up to date with the grid, patching only the
+ * cells that changed when it showed the generation before this one.
+ */
+void update_renderer(CellRenderer &renderer, const BitGrid &grid) {
+    auto patch = [&](Position pos, bool alive) { renderer.set(pos, alive); };
+    if (renderer.generation() + 1 != grid.generation() ||
+        !grid.each_change(patch)) {
+        renderer.clear();
+        grid.each_alive([&](Position pos) { renderer.set(pos, true); });
+    }
+    renderer.set_generation(grid.generation());
+}
+
+/**
+ * Render the current state of the grid.
+ */
+void render_system(sf::RenderWindow &window, CellRenderer &renderer,
+                   const BitGrid &grid) {
+    GOL_TIME("render_system");
+    update_renderer(renderer, grid);
+
+    window.clear(sf::Color::Black);
+    renderer.draw(window);
+    window.display();
+}
+
+/**
+ * Nothing to clean up, cells that die are simply absent from the back buffer.
+ */
+void cleanup_system(BitGrid &grid) {}
+
+/**
+ * Make the next generation the current one.
+ */
+void update_system(BitGrid &grid) {
+    GOL_TIME("update_system");
+    grid.swap();
+}
+
+/**
+ * Advance the grid a whole generation, the same as running the lifecycle,
+ * cleanup and update systems.
+ */
+void step_system(BitGrid &grid) {
+    GOL_TIME("step_system");
+    grid.step();
+    grid.swap();
+}
+
+/**
+ * Copy the positions of the live cells into the snapshot, reusing its buffer.
+ */
+void snapshot_system(const BitGrid &grid, Snapshot &snapshot) {
+    GOL_TIME("snapshot_system");
+    snapshot.live.clear();
+    grid.each_alive([&](Position pos) { snapshot.live.push_back(pos); });
+}
+
+/**
+ * Initialise the universe with live cells at random positions in the arena,
+ * from a fresh random seed.
+ */
+bool initialise_hashlife(Hashlife &life, int n_alive_cells, int arena_x_max,
+                         int arena_y_max) {
+    RandGen rand_gen(random_seed());
+    return initialise_hashlife(life, n_alive_cells, arena_x_max, arena_y_max,
+                               rand_gen);
+}
+
+/**
+ * Initialise the universe with live cells at random positions in the arena.
+ * The universe itself is unbounded, cells can leave the arena later on.
+ * Returns false if the arena is too big to number its cells.
+ */
+bool initialise_hashlife(Hashlife &life, int n_alive_cells, int arena_x_max,
+                         int arena_y_max, RandGen &rand_gen) {
+    if (!arena_fits_index(arena_x_max, arena_y_max)) {
+        return false;
+    }
+    for (auto cell : sample_cells(arena_x_max * arena_y_max, n_alive_cells,
+                                  rand_gen)) {
+        life.set(cell % arena_x_max, cell / arena_x_max, true);
+    }
+    return true;
+}
+
+/**
+ * Set the live cells read from a pattern or checkpoint, moved to x, y, in the
+ * universe. The universe is unbounded so every cell is kept.
+ */
+template <typename Cells>
+static bool read_hashlife(Hashlife &life, const Cells &source, std::int64_t x,
+                          std::int64_t y) {
+    return source.read(
+        x, y, [&](const Position *cells, std::size_t n_cells) {
+            for (auto cell = cells; cell != cells + n_cells; cell++) {
+                life.set(cell->x, cell->y, true);
+            }
+        });
+}
+
+/**
+ * Initialise the universe with the live cells of a pattern, centred in the
+ * arena. The universe is unbounded so every cell is kept. Returns false if
+ * the pattern is malformed.
+ */
+bool load_hashlife(Hashlife &life, const PatternFile &pattern, int arena_x_max,
+                   int arena_y_max) {
+    std::int64_t x, y;
+    pattern_origin(pattern, arena_x_max, arena_y_max, x, y);
+    return read_hashlife(life, pattern, x, y);
+}
+
+/**
+ * Initialise the universe with the live cells of a checkpoint, including any
+ * outside of its arena. Returns false if the checkpoint is malformed.
+ */
+bool restore_hashlife(Hashlife &life, const CheckpointFile &checkpoint) {
+    return read_hashlife(life, checkpoint, 0, 0);
+}
+
+/**
+ * Redraw the renderer's pixels from the part of the universe it covers.
+ * Jumps can move any number of generations on, so every live cell is drawn.
+ */
+void update_renderer(CellRenderer &renderer, const Hashlife &life) {
+    renderer.clear();
+    life.each_alive(0, 0, renderer.board_width(), renderer.board_height(),
+                    [&](std::int64_t x, std::int64_t y) {
+                        renderer.set(Position(int(x), int(y)), true);
+                    });
+    renderer.set_generation(std::int64_t(life.generation()));
+}
+
+/**
+ * Render the part of the universe inside the window.
+ */
+void render_system(sf::RenderWindow &window, CellRenderer &renderer,
+                   const Hashlife &life) {
+    GOL_TIME("render_system");
+    update_renderer(renderer, life);
+
+    window.clear(sf::Color::Black);
+    renderer.draw(window);
+    window.display();
+}
+
+/**
+ * Advance the universe by the given number of generations, jumping by each
+ * power of two that makes it up.
+ */
+void step_system(Hashlife &life, std::uint64_t n_generations) {
+    GOL_TIME("step_system");
+    life.step(n_generations);
+    LOG_DEBUG("Hashlife holds " << life.node_count() << " nodes");
+}
+
+/**
+ * Copy the positions of the live cells that fit in a Position into the
+ * snapshot, reusing its buffer.
+ */
+void snapshot_system(const Hashlife &life, Snapshot &snapshot) {
+    GOL_TIME("snapshot_system");
+    snapshot.live.clear();
+    life.each_alive(std::numeric_limits<int>::min(),
+                    std::numeric_limits<int>::min(),
+                    std::int64_t(std::numeric_limits<int>::max()) + 1,
+                    std::int64_t(std::numeric_limits<int>::max()) + 1,
+                    [&](std::int64_t x, std::int64_t y) {
+                        snapshot.live.emplace_back(int(x), int(y));
+                    });
+}
+
+/**
+ * Redraw the renderer's pixels from a snapshot. Snapshots can be skipped, so
+ * there are no changes to patch from and every live cell is drawn.
+ */
+void update_renderer(CellRenderer &renderer, const Snapshot &snapshot) {
+    renderer.clear();
+    for (auto pos : snapshot.live) {
+        renderer.set(pos, true);
+    }
+    renderer.set_generation(snapshot.generation);
+}
+
+/**
+ * Render a snapshot of the live cells.
+ */
+void render_system(sf::RenderWindow &window, CellRenderer &renderer,
+                   const Snapshot &snapshot) {
+    GOL_TIME("render_system");
+    update_renderer(renderer, snapshot);
+
+    window.clear(sf::Color::Black);
+    renderer.draw(window);
+    window.display();
 }
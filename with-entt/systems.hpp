@@ -1,12 +1,72 @@
 #pragma once
 
+#include <cstdint>
+
 #include <SFML/Graphics.hpp>
 #include <entt/entt.hpp>
 
-void initialise_registry(entt::registry &registry, int n_alive_cells,
+#include "bitgrid.hpp"
+#include "checkpoint.hpp"
+#include "hashlife.hpp"
+#include "pattern.hpp"
+#include "random.hpp"
+#include "renderer.hpp"
+#include "snapshot.hpp"
+
+bool arena_fits_index(int arena_x_max, int arena_y_max);
+bool initialise_registry(entt::registry &registry, int n_alive_cells,
                          int arena_x_max, int arena_y_max);
+bool initialise_registry(entt::registry &registry, int n_alive_cells,
+                         int arena_x_max, int arena_y_max, RandGen &rand_gen);
+void initialise_sparse_registry(entt::registry &registry, int n_alive_cells,
+                                int arena_x_max, int arena_y_max);
+void initialise_sparse_registry(entt::registry &registry, int n_alive_cells,
+                                int arena_x_max, int arena_y_max,
+                                RandGen &rand_gen);
+bool load_registry(entt::registry &registry, const PatternFile &pattern,
+                   int arena_x_max, int arena_y_max);
+bool load_sparse_registry(entt::registry &registry,
+                          const PatternFile &pattern, int arena_x_max,
+                          int arena_y_max);
+bool restore_registry(entt::registry &registry,
+                      const CheckpointFile &checkpoint);
+bool restore_sparse_registry(entt::registry &registry,
+                             const CheckpointFile &checkpoint);
 void lifecycle_system(entt::registry &registry);
-void render_system(sf::RenderWindow &window, int scale,
+void update_renderer(CellRenderer &renderer, entt::registry &registry);
+void render_system(sf::RenderWindow &window, CellRenderer &renderer,
                    entt::registry &registry);
 void cleanup_system(entt::registry &registry);
 void update_system(entt::registry &registry);
+void step_system(entt::registry &registry);
+void snapshot_system(entt::registry &registry, Snapshot &snapshot);
+
+void initialise_grid(BitGrid &grid, int n_alive_cells);
+void initialise_grid(BitGrid &grid, int n_alive_cells, RandGen &rand_gen);
+bool load_grid(BitGrid &grid, const PatternFile &pattern);
+bool restore_grid(BitGrid &grid, const CheckpointFile &checkpoint);
+void lifecycle_system(BitGrid &grid);
+void update_renderer(CellRenderer &renderer, const BitGrid &grid);
+void render_system(sf::RenderWindow &window, CellRenderer &renderer,
+                   const BitGrid &grid);
+void cleanup_system(BitGrid &grid);
+void update_system(BitGrid &grid);
+void step_system(BitGrid &grid);
+void snapshot_system(const BitGrid &grid, Snapshot &snapshot);
+
+bool initialise_hashlife(Hashlife &life, int n_alive_cells, int arena_x_max,
+                         int arena_y_max);
+bool initialise_hashlife(Hashlife &life, int n_alive_cells, int arena_x_max,
+                         int arena_y_max, RandGen &rand_gen);
+bool load_hashlife(Hashlife &life, const PatternFile &pattern, int arena_x_max,
+                   int arena_y_max);
+bool restore_hashlife(Hashlife &life, const CheckpointFile &checkpoint);
+void update_renderer(CellRenderer &renderer, const Hashlife &life);
+void render_system(sf::RenderWindow &window, CellRenderer &renderer,
+                   const Hashlife &life);
+void step_system(Hashlife &life, std::uint64_t n_generations = 1);
+void snapshot_system(const Hashlife &life, Snapshot &snapshot);
+
+void update_renderer(CellRenderer &renderer, const Snapshot &snapshot);
+void render_system(sf::RenderWindow &window, CellRenderer &renderer,
+                   const Snapshot &snapshot);
@@ -1,20 +1,50 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
+#include <new>
+#include <random>
 #include <sstream>
+#include <string>
 #include <unordered_set>
 
 #include <doctest.h>
 #include <entt/entt.hpp>
 
+#include "backends.hpp"
+#include "checkpoint.hpp"
 #include "components.hpp"
+#include "grid.hpp"
+#include "pattern.hpp"
+#include "random.hpp"
+#include "renderer.hpp"
+#include "rule.hpp"
 #include "systems.hpp"
+#include "thread_pool.hpp"
+#include "topology.hpp"
 #include "utils.hpp"
 
 #include "log.hpp"
 
+// Count every heap allocation made by the tests
+static std::atomic<long> allocations(0);
+
+void *operator new(std::size_t size) {
+    allocations++;
+    if (auto ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
 void set_neighbours(entt::registry &reg, int n_neighbours) {}
 
 template <typename T>
@@ -40,6 +70,44 @@ std::ostream &operator<<(std::ostream &stream,
     return stream;
 }
 
+/**
+ * The positions of the registry's live cells.
+ */
+std::unordered_set<Position> alive_positions(entt::registry &registry) {
+    std::unordered_set<Position> alive;
+    registry.view<Position, entt::tag<"is_alive"_hs>>().each(
+        [&](auto &pos, auto _) { alive.insert(pos); });
+    return alive;
+}
+
+/**
+ * Fill the registry with a cell at every position on the board, the given
+ * ones alive.
+ */
+void fill_board(entt::registry &registry, int width, int height,
+                const std::unordered_set<Position> &alive) {
+    for (auto x = 0; x < width; x++) {
+        for (auto y = 0; y < height; y++) {
+            auto entity = registry.create();
+            registry.assign<Position>(entity, x, y);
+            if (alive.count(Position(x, y))) {
+                registry.assign<entt::tag<"is_alive"_hs>>(entity);
+            }
+        }
+    }
+}
+
+/**
+ * A blinker and a block on a 20x20 board, which settle into a period two
+ * cycle of seven live cells.
+ */
+void fill_blinker_and_block(entt::registry &registry) {
+    fill_board(registry, 20, 20,
+               {Position(2, 3), Position(3, 3), Position(4, 3),
+                Position(10, 10), Position(10, 11), Position(11, 10),
+                Position(11, 11)});
+}
+
 TEST_SUITE("initialise_registry") {
     TEST_CASE(
         "the registry is initialise with the number of given live cells") {
@@ -83,6 +151,50 @@ TEST_SUITE("initialise_registry") {
         });
     }
 
+    TEST_CASE("every position in the arena has exactly one cell") {
+        entt::registry registry;
+        initialise_registry(registry, 30, 12, 7);
+
+        std::unordered_set<Position> positions;
+        registry.view<Position>().each(
+            [&](auto &pos) { REQUIRE(positions.insert(pos).second); });
+        REQUIRE(positions.size() == 12 * 7);
+    }
+
+    TEST_CASE("live cells are capped at the area of the arena") {
+        entt::registry registry;
+        initialise_registry(registry, 200, 10, 10);
+
+        auto count = 0;
+        registry.view<entt::tag<"is_alive"_hs>>().each(
+            [&](auto entity, auto _) { count++; });
+        REQUIRE(count == 100);
+    }
+
+    TEST_CASE("arenas too big to number their cells are rejected") {
+        entt::registry registry;
+        RandGen rand_gen(1);
+        REQUIRE_FALSE(initialise_registry(registry, 10, 100000, 100000,
+                                          rand_gen));
+        REQUIRE(registry.view<Position>().empty());
+    }
+
+    TEST_CASE("the same seed gives the same live cells") {
+        entt::registry registry_0, registry_1;
+        RandGen rand_gen_0(99), rand_gen_1(99);
+        initialise_registry(registry_0, 20, 10, 10, rand_gen_0);
+        initialise_registry(registry_1, 20, 10, 10, rand_gen_1);
+
+        std::unordered_set<Position> alive_reg_0, alive_reg_1;
+        registry_0.view<Position, entt::tag<"is_alive"_hs>>().each(
+            [&](auto &pos, auto _) { alive_reg_0.insert(pos); });
+        registry_1.view<Position, entt::tag<"is_alive"_hs>>().each(
+            [&](auto &pos, auto _) { alive_reg_1.insert(pos); });
+
+        REQUIRE(alive_reg_0.size() == 20);
+        REQUIRE(alive_reg_0 == alive_reg_1);
+    }
+
     TEST_CASE(
         "the alive cells in the registry are randomly assigned positions") {
         entt::registry registry_0, registry_1;
@@ -256,8 +368,9 @@ TEST_SUITE("lifecycle_system") {
         auto neighbour_count = 3;
         auto cell_pos = Position(2, 2);
         int x_dim = 5, y_dim = 5;
-        std::vector<Position> possible_neighbours =
-            find_possible_neighbours(cell_pos);
+        auto cell_neighbours = find_possible_neighbours(cell_pos);
+        std::vector<Position> possible_neighbours(cell_neighbours.begin(),
+                                                  cell_neighbours.end());
         std::unordered_set<Position> neighbours;
 
         neighbours.clear();
@@ -436,5 +549,832 @@ TEST_SUITE("update_system") {
     }
 }
 
+TEST_SUITE("sparse mode") {
+    void generation(entt::registry &registry) {
+        lifecycle_system(registry);
+        cleanup_system(registry);
+        update_system(registry);
+    }
+
+    TEST_CASE("only live cells are created") {
+        entt::registry registry;
+        initialise_sparse_registry(registry, 10, 100, 100);
+
+        REQUIRE(registry.view<Position>().size() == 10);
+        REQUIRE(alive_positions(registry).size() == 10);
+    }
+
+    TEST_CASE("cells are created on birth and destroyed on death") {
+        entt::registry registry;
+        registry.set<SparseGrid>(5, 5);
+        for (auto x = 1; x < 4; x++) {
+            auto entity = registry.create();
+            registry.assign<Position>(entity, x, 2);
+            registry.assign<entt::tag<"is_alive"_hs>>(entity);
+        }
+
+        generation(registry);
+
+        REQUIRE(registry.view<Position>().size() == 3);
+        REQUIRE(alive_positions(registry) ==
+                std::unordered_set<Position>{Position(2, 1), Position(2, 2),
+                                             Position(2, 3)});
+    }
+
+    TEST_CASE("a lone cell dies and leaves no entities behind") {
+        entt::registry registry;
+        registry.set<SparseGrid>(5, 5);
+        auto entity = registry.create();
+        registry.assign<Position>(entity, 2, 2);
+        registry.assign<entt::tag<"is_alive"_hs>>(entity);
+
+        generation(registry);
+
+        REQUIRE(registry.view<Position>().size() == 0);
+        REQUIRE_FALSE(has_alive_cells(registry));
+    }
+
+    TEST_CASE("matches the dense registry") {
+        int x_dim = 12, y_dim = 12;
+        std::random_device rand_dev;
+        std::mt19937 rand_gen(rand_dev());
+        std::bernoulli_distribution alive(0.4);
+
+        entt::registry dense, sparse;
+        sparse.set<SparseGrid>(x_dim, y_dim);
+        for (auto x = 0; x < x_dim; x++) {
+            for (auto y = 0; y < y_dim; y++) {
+                auto entity = dense.create();
+                dense.assign<Position>(entity, x, y);
+                if (alive(rand_gen)) {
+                    dense.assign<entt::tag<"is_alive"_hs>>(entity);
+                    entity = sparse.create();
+                    sparse.assign<Position>(entity, x, y);
+                    sparse.assign<entt::tag<"is_alive"_hs>>(entity);
+                }
+            }
+        }
+
+        for (auto round = 0; round < 10; round++) {
+            CAPTURE(round);
+            REQUIRE(alive_positions(sparse) == alive_positions(dense));
+            REQUIRE(sparse.view<Position>().size() ==
+                    alive_positions(sparse).size());
+            generation(dense);
+            generation(sparse);
+        }
+    }
+}
+
+TEST_SUITE("threaded lifecycle_system") {
+    TEST_CASE("tags the same cells as the single threaded lifecycle") {
+        int x_dim = 150, y_dim = 140;
+        std::random_device rand_dev;
+        std::mt19937 rand_gen(rand_dev());
+        std::bernoulli_distribution alive(0.3);
+
+        entt::registry single, threaded;
+        threaded.set<ThreadPool>(4);
+        for (auto x = 0; x < x_dim; x++) {
+            for (auto y = 0; y < y_dim; y++) {
+                auto is_alive = alive(rand_gen);
+                for (auto registry : {&single, &threaded}) {
+                    auto entity = registry->create();
+                    registry->assign<Position>(entity, x, y);
+                    if (is_alive) {
+                        registry->assign<entt::tag<"is_alive"_hs>>(entity);
+                    }
+                }
+            }
+        }
+
+        for (auto round = 0; round < 3; round++) {
+            lifecycle_system(single);
+            lifecycle_system(threaded);
+
+            std::unordered_set<Position> single_next, threaded_next;
+            single.view<Position, entt::tag<"is_alive_next"_hs>>().each(
+                [&](auto &pos, auto _) { single_next.insert(pos); });
+            threaded.view<Position, entt::tag<"is_alive_next"_hs>>().each(
+                [&](auto &pos, auto _) { threaded_next.insert(pos); });
+
+            CAPTURE(round);
+            REQUIRE(single_next == threaded_next);
+
+            for (auto registry : {&single, &threaded}) {
+                cleanup_system(*registry);
+                update_system(*registry);
+            }
+        }
+    }
+}
+
+TEST_SUITE("steady state") {
+    TEST_CASE("a generation performs no heap allocations") {
+        entt::registry registry;
+        SUBCASE("single threaded") {}
+        SUBCASE("threaded") { registry.set<ThreadPool>(2); }
+
+        fill_blinker_and_block(registry);
+
+        auto generation = [&] {
+            lifecycle_system(registry);
+            cleanup_system(registry);
+            update_system(registry);
+        };
+
+        // Let the grid, pools and buffers reach their steady state sizes
+        for (auto round = 0; round < 4; round++) {
+            generation();
+        }
+
+        auto before = allocations.load();
+        for (auto round = 0; round < 4; round++) {
+            generation();
+        }
+        REQUIRE(allocations.load() - before == 0);
+        REQUIRE(has_alive_cells(registry));
+    }
+
+    TEST_CASE("a bit grid generation performs no heap allocations") {
+        BitGrid grid(100, 100);
+        grid.set(50, 50, true);
+        grid.set(51, 50, true);
+        grid.set(52, 50, true);
+
+        auto before = allocations.load();
+        for (auto round = 0; round < 4; round++) {
+            lifecycle_system(grid);
+            cleanup_system(grid);
+            update_system(grid);
+        }
+        REQUIRE(allocations.load() - before == 0);
+    }
+}
+
+TEST_SUITE("lifecycle_system scaling") {
+    /**
+     * Heap allocations made by the first lifecycle of a dim x dim board with
+     * about a third of it alive. Unlike its time, this is the same on every
+     * machine.
+     */
+    long lifecycle_allocations(int dim) {
+        std::mt19937 rand_gen(7);
+        std::bernoulli_distribution is_alive(0.3);
+        std::unordered_set<Position> alive;
+        for (auto x = 0; x < dim; x++) {
+            for (auto y = 0; y < dim; y++) {
+                if (is_alive(rand_gen)) {
+                    alive.insert(Position(x, y));
+                }
+            }
+        }
+        entt::registry registry;
+        fill_board(registry, dim, dim, alive);
+
+        auto before = allocations.load();
+        lifecycle_system(registry);
+        return allocations.load() - before;
+    }
+
+    TEST_CASE("work per cell does not grow with the number of live cells") {
+        // The bigger board has 16 times the cells. Copying the live cells for
+        // each cell would make 16 times as many allocations per cell on it, a
+        // linear lifecycle only grows its buffers a few more times.
+        auto small = lifecycle_allocations(64);
+        auto large = lifecycle_allocations(256);
+
+        CAPTURE(small);
+        CAPTURE(large);
+        REQUIRE(small > 0);
+        REQUIRE(large < 4 * 16 * small);
+    }
+}
+
+TEST_SUITE("step_system") {
+    TEST_CASE("cells follow the rules of the game") {
+        for (auto neighbour_count = 0; neighbour_count <= 8;
+             neighbour_count++) {
+            for (auto alive : {false, true}) {
+                CAPTURE(neighbour_count);
+                CAPTURE(alive);
+
+                entt::registry registry;
+                auto cell_pos = Position(2, 2);
+                auto neighbours = find_possible_neighbours(cell_pos);
+                entt::entity cell;
+                for (auto x = 0; x < 5; x++) {
+                    for (auto y = 0; y < 5; y++) {
+                        auto pos = Position(x, y);
+                        auto entity = registry.create();
+                        registry.assign<Position>(entity, pos);
+                        auto is_neighbour =
+                            std::find(neighbours.begin(),
+                                      neighbours.begin() + neighbour_count,
+                                      pos) !=
+                            neighbours.begin() + neighbour_count;
+                        if (is_neighbour || (alive && pos == cell_pos)) {
+                            registry.assign<entt::tag<"is_alive"_hs>>(entity);
+                        }
+                        if (pos == cell_pos) {
+                            cell = entity;
+                        }
+                    }
+                }
+
+                step_system(registry);
+
+                auto expected =
+                    neighbour_count == 3 || (alive && neighbour_count == 2);
+                REQUIRE(registry.has<entt::tag<"is_alive"_hs>>(cell) ==
+                        expected);
+                REQUIRE(!registry.has<entt::tag<"is_alive_next"_hs>>(cell));
+            }
+        }
+    }
+
+    TEST_CASE("matches running the lifecycle, cleanup and update systems") {
+        entt::registry stepped, systems;
+        RandGen rand_gen_0(11), rand_gen_1(11);
+        SUBCASE("dense") {
+            initialise_registry(stepped, 500, 50, 40, rand_gen_0);
+            initialise_registry(systems, 500, 50, 40, rand_gen_1);
+        }
+        SUBCASE("threaded") {
+            initialise_registry(stepped, 500, 50, 40, rand_gen_0);
+            initialise_registry(systems, 500, 50, 40, rand_gen_1);
+            stepped.set<ThreadPool>(3);
+        }
+        SUBCASE("sparse") {
+            initialise_sparse_registry(stepped, 500, 50, 40, rand_gen_0);
+            initialise_sparse_registry(systems, 500, 50, 40, rand_gen_1);
+        }
+
+        for (auto round = 0; round < 20; round++) {
+            CAPTURE(round);
+            step_system(stepped);
+            lifecycle_system(systems);
+            cleanup_system(systems);
+            update_system(systems);
+
+            REQUIRE(alive_positions(stepped) == alive_positions(systems));
+            REQUIRE(stepped.view<Position>().size() ==
+                    systems.view<Position>().size());
+        }
+    }
+
+    TEST_CASE("matches the systems across many tiles") {
+        entt::registry stepped, systems;
+        RandGen rand_gen_0(12), rand_gen_1(12);
+        initialise_registry(stepped, 6000, 300, 200, rand_gen_0);
+        initialise_registry(systems, 6000, 300, 200, rand_gen_1);
+        SUBCASE("single threaded") {}
+        SUBCASE("threaded") { stepped.set<ThreadPool>(3); }
+
+        for (auto round = 0; round < 30; round++) {
+            CAPTURE(round);
+            step_system(stepped);
+            lifecycle_system(systems);
+            cleanup_system(systems);
+            update_system(systems);
+            REQUIRE(alive_positions(stepped) == alive_positions(systems));
+        }
+    }
+
+    TEST_CASE("settled regions of the board are skipped") {
+        entt::registry registry;
+        // A block in one corner and a blinker in the other
+        fill_board(registry, 320, 320,
+                   {Position(10, 10), Position(10, 11), Position(11, 10),
+                    Position(11, 11), Position(300, 300), Position(301, 300),
+                    Position(302, 300)});
+
+        step_system(registry);
+        auto &grid = registry.ctx<LiveGrid>();
+        REQUIRE(grid.active_tile_count() ==
+                static_cast<std::size_t>(grid.tile_count()));
+
+        // Only the blinker's tile and the eight tiles around it stay active
+        for (auto round = 0; round < 4; round++) {
+            step_system(registry);
+            REQUIRE(grid.active_tile_count() == 9);
+        }
+        REQUIRE(alive_positions(registry).size() == 7);
+    }
+
+    TEST_CASE("matches the systems on a bit grid") {
+        BitGrid stepped(70, 12), systems(70, 12);
+        RandGen rand_gen_0(3), rand_gen_1(3);
+        initialise_grid(stepped, 300, rand_gen_0);
+        initialise_grid(systems, 300, rand_gen_1);
+
+        for (auto round = 0; round < 20; round++) {
+            step_system(stepped);
+            lifecycle_system(systems);
+            cleanup_system(systems);
+            update_system(systems);
+            for (auto x = 0; x < 70; x++) {
+                for (auto y = 0; y < 12; y++) {
+                    REQUIRE(stepped.get(x, y) == systems.get(x, y));
+                }
+            }
+        }
+    }
+
+    TEST_CASE("other rules match on every backend") {
+        // B36/S125 has no kernel of its own and is looked up from its mask
+        auto rule = conway_rule;
+        SUBCASE("HighLife") { rule = highlife_rule; }
+        SUBCASE("Seeds") { rule = seeds_rule; }
+        SUBCASE("Day & Night") { rule = day_and_night_rule; }
+        SUBCASE("B36/S125") { REQUIRE(parse_rule("B36/S125", rule)); }
+        CAPTURE(rule_name(rule));
+
+        entt::registry dense, threaded, sparse, systems;
+        BitGrid grid(60, 40);
+        RandGen rand_gen_0(13), rand_gen_1(13), rand_gen_2(13);
+        initialise_registry(dense, 600, 60, 40, rand_gen_0);
+        initialise_registry(threaded, 600, 60, 40, rand_gen_1);
+        initialise_registry(systems, 600, 60, 40, rand_gen_2);
+        // The sparse registry and grid lay their cells out differently, so
+        // copy them over
+        sparse.set<SparseGrid>(60, 40);
+        for (auto pos : alive_positions(systems)) {
+            auto entity = sparse.create();
+            sparse.assign<Position>(entity, pos);
+            sparse.assign<entt::tag<"is_alive"_hs>>(entity);
+            grid.set(pos.x, pos.y, true);
+        }
+        threaded.set<ThreadPool>(3);
+        for (auto registry : {&dense, &threaded, &sparse, &systems}) {
+            registry->set<Rule>(rule);
+        }
+        grid.set_rule(rule);
+
+        for (auto round = 0; round < 12; round++) {
+            CAPTURE(round);
+            step_system(dense);
+            step_system(threaded);
+            step_system(sparse);
+            lifecycle_system(systems);
+            cleanup_system(systems);
+            update_system(systems);
+            step_system(grid);
+
+            auto expected = alive_positions(systems);
+            REQUIRE(alive_positions(dense) == expected);
+            REQUIRE(alive_positions(threaded) == expected);
+            REQUIRE(alive_positions(sparse) == expected);
+            std::unordered_set<Position> grid_alive;
+            grid.each_alive([&](Position pos) { grid_alive.insert(pos); });
+            REQUIRE(grid_alive == expected);
+        }
+    }
+
+    TEST_CASE("a step performs no heap allocations") {
+        entt::registry registry;
+        SUBCASE("single threaded") {}
+        SUBCASE("threaded") { registry.set<ThreadPool>(2); }
+
+        fill_blinker_and_block(registry);
+
+        for (auto round = 0; round < 4; round++) {
+            step_system(registry);
+        }
+
+        auto before = allocations.load();
+        for (auto round = 0; round < 4; round++) {
+            step_system(registry);
+        }
+        REQUIRE(allocations.load() - before == 0);
+        REQUIRE(alive_positions(registry).size() == 7);
+    }
+}
+
+TEST_SUITE("update_renderer") {
+    void generation(entt::registry &registry) {
+        lifecycle_system(registry);
+        cleanup_system(registry);
+        update_system(registry);
+    }
+
+    void generation(BitGrid &grid) {
+        lifecycle_system(grid);
+        cleanup_system(grid);
+        update_system(grid);
+    }
+
+    void require_matches(const CellRenderer &renderer,
+                         entt::registry &registry, int width, int height) {
+        auto alive = alive_positions(registry);
+        for (auto x = 0; x < width; x++) {
+            for (auto y = 0; y < height; y++) {
+                CAPTURE(Position(x, y));
+                REQUIRE(renderer.get(Position(x, y)) ==
+                        (alive.count(Position(x, y)) == 1));
+            }
+        }
+    }
+
+    TEST_CASE("patched pixels follow the registry") {
+        entt::registry registry;
+        RandGen rand_gen(5);
+        SUBCASE("dense") {
+            initialise_registry(registry, 400, 40, 30, rand_gen);
+        }
+        SUBCASE("sparse") {
+            initialise_sparse_registry(registry, 400, 40, 30, rand_gen);
+        }
+
+        CellRenderer renderer(40, 30, 1);
+        update_renderer(renderer, registry);
+        require_matches(renderer, registry, 40, 30);
+        for (auto round = 0; round < 10; round++) {
+            generation(registry);
+            update_renderer(renderer, registry);
+            require_matches(renderer, registry, 40, 30);
+        }
+    }
+
+    TEST_CASE("pixels follow the registry over several generations a frame") {
+        entt::registry registry;
+        RandGen rand_gen(5);
+        SUBCASE("dense") {
+            initialise_registry(registry, 400, 40, 30, rand_gen);
+        }
+        SUBCASE("sparse") {
+            initialise_sparse_registry(registry, 400, 40, 30, rand_gen);
+        }
+
+        // As with --jump, cells can be born and die again between frames
+        CellRenderer renderer(40, 30, 1);
+        update_renderer(renderer, registry);
+        for (auto round = 0; round < 5; round++) {
+            step_system(registry);
+            step_system(registry);
+            update_renderer(renderer, registry);
+            require_matches(renderer, registry, 40, 30);
+        }
+    }
+
+    TEST_CASE("only the cells that changed are recorded") {
+        entt::registry registry;
+        for (auto x = 0; x < 5; x++) {
+            for (auto y = 0; y < 5; y++) {
+                auto entity = registry.create();
+                registry.assign<Position>(entity, x, y);
+                if (y == 2 && x >= 1 && x <= 3) {
+                    registry.assign<entt::tag<"is_alive"_hs>>(entity);
+                }
+            }
+        }
+        CellRenderer renderer(5, 5, 1);
+        update_renderer(renderer, registry);
+
+        // The blinker's two ends die and two cells are born above and below
+        generation(registry);
+        auto &changes = registry.ctx<CellChanges>();
+        REQUIRE(std::unordered_set<Position>(changes.died.begin(),
+                                             changes.died.end()) ==
+                std::unordered_set<Position>{Position(1, 2), Position(3, 2)});
+        REQUIRE(std::unordered_set<Position>(changes.born.begin(),
+                                             changes.born.end()) ==
+                std::unordered_set<Position>{Position(2, 1), Position(2, 3)});
+
+        update_renderer(renderer, registry);
+        REQUIRE(changes.died.empty());
+        REQUIRE(changes.born.empty());
+    }
+
+    TEST_CASE("patched pixels follow the bit grid") {
+        BitGrid grid(70, 20);
+        RandGen rand_gen(5);
+        initialise_grid(grid, 500, rand_gen);
+
+        CellRenderer renderer(70, 20, 1);
+        update_renderer(renderer, grid);
+        for (auto round = 0; round < 10; round++) {
+            generation(grid);
+            REQUIRE(grid.each_change([](Position, bool) {}));
+            update_renderer(renderer, grid);
+            REQUIRE(renderer.generation() == grid.generation());
+            for (auto x = 0; x < 70; x++) {
+                for (auto y = 0; y < 20; y++) {
+                    REQUIRE(renderer.get(Position(x, y)) == grid.get(x, y));
+                }
+            }
+        }
+    }
+
+    TEST_CASE("only the part of a hashlife universe on the board is drawn") {
+        Hashlife life;
+        RandGen rand_gen(9);
+        initialise_hashlife(life, 300, 40, 20, rand_gen);
+        life.set(-1, 5, true);
+        life.set(45, 5, true);
+        step_system(life, 16);
+
+        CellRenderer renderer(40, 20, 1);
+        update_renderer(renderer, life);
+        REQUIRE(renderer.generation() == 16);
+        for (auto x = 0; x < 40; x++) {
+            for (auto y = 0; y < 20; y++) {
+                REQUIRE(renderer.get(Position(x, y)) == life.get(x, y));
+            }
+        }
+    }
+}
+
+TEST_SUITE("snapshot_system") {
+    TEST_CASE("snapshots hold the live cells") {
+        entt::registry registry;
+        BitGrid grid(20, 20);
+        std::unordered_set<Position> alive = {Position(0, 0), Position(5, 7),
+                                              Position(19, 19)};
+        for (auto x = 0; x < 20; x++) {
+            for (auto y = 0; y < 20; y++) {
+                auto entity = registry.create();
+                registry.assign<Position>(entity, x, y);
+                if (alive.count(Position(x, y))) {
+                    registry.assign<entt::tag<"is_alive"_hs>>(entity);
+                    grid.set(x, y, true);
+                }
+            }
+        }
+
+        Snapshot snapshot;
+        snapshot.live.emplace_back(1, 1);
+        snapshot_system(registry, snapshot);
+        REQUIRE(std::unordered_set<Position>(snapshot.live.begin(),
+                                             snapshot.live.end()) == alive);
+        REQUIRE(snapshot.live.size() == alive.size());
+
+        snapshot_system(grid, snapshot);
+        REQUIRE(std::unordered_set<Position>(snapshot.live.begin(),
+                                             snapshot.live.end()) == alive);
+        REQUIRE(snapshot.live.size() == alive.size());
+
+        CellRenderer renderer(20, 20, 1);
+        snapshot.generation = 3;
+        update_renderer(renderer, snapshot);
+        REQUIRE(renderer.generation() == 3);
+        REQUIRE(renderer.get(Position(5, 7)));
+        REQUIRE_FALSE(renderer.get(Position(1, 1)));
+    }
+}
 
 TEST_SUITE("render_system" * doctest::skip()) {}
+
+TEST_SUITE("loading patterns") {
+    TEST_CASE("every backend places a pattern in the middle of the board") {
+        std::string text = "x = 3, y = 3\nbo$2bo$3o!";
+        PatternFile pattern;
+        REQUIRE(pattern.view(text.data(), text.size()));
+        std::unordered_set<Position> expected = {
+            Position(9, 8), Position(10, 9), Position(8, 10), Position(9, 10),
+            Position(10, 10)};
+
+        entt::registry dense, sparse;
+        REQUIRE(load_registry(dense, pattern, 20, 20));
+        REQUIRE(alive_positions(dense) == expected);
+        REQUIRE(load_sparse_registry(sparse, pattern, 20, 20));
+        REQUIRE(alive_positions(sparse) == expected);
+
+        BitGrid grid(20, 20);
+        REQUIRE(load_grid(grid, pattern));
+        std::unordered_set<Position> grid_alive;
+        grid.each_alive([&](Position pos) { grid_alive.insert(pos); });
+        REQUIRE(grid_alive == expected);
+
+        Hashlife life;
+        REQUIRE(load_hashlife(life, pattern, 20, 20));
+        std::unordered_set<Position> life_alive;
+        life.each_alive(0, 0, 20, 20, [&](std::int64_t x, std::int64_t y) {
+            life_alive.insert(Position(int(x), int(y)));
+        });
+        REQUIRE(life_alive == expected);
+    }
+
+    TEST_CASE("cells off the board are dropped") {
+        std::string text = "#Life 1.06\n0 0\n-1 0\n5 5\n";
+        PatternFile pattern;
+        REQUIRE(pattern.view(text.data(), text.size()));
+
+        entt::registry registry;
+        REQUIRE(load_registry(registry, pattern, 4, 4));
+        REQUIRE(alive_positions(registry) ==
+                std::unordered_set<Position>{Position(2, 2), Position(1, 2)});
+
+        BitGrid grid(4, 4);
+        REQUIRE(load_grid(grid, pattern));
+        REQUIRE(grid.get(1, 2));
+        REQUIRE(grid.get(2, 2));
+    }
+}
+
+TEST_SUITE("restoring checkpoints") {
+    /**
+     * Save a checkpoint of the world and map it back.
+     */
+    template <typename World>
+    void checkpoint(World &world, CheckpointFile &file) {
+        Checkpoint checkpoint;
+        checkpoint.width = 40;
+        checkpoint.height = 30;
+        checkpoint.rule = highlife_rule;
+        snapshot_system(world, checkpoint.snapshot);
+        checkpoint.snapshot.generation = 20;
+        auto path = (std::filesystem::temp_directory_path() /
+                     "gol_systems_test.ckpt")
+                        .string();
+        REQUIRE(save_checkpoint(path, checkpoint));
+        REQUIRE(file.open(path));
+        std::filesystem::remove(path);
+    }
+
+    TEST_CASE("arenas too big to number their cells aren't restored dense") {
+        Checkpoint checkpoint;
+        checkpoint.width = 100000;
+        checkpoint.height = 100000;
+        auto path = (std::filesystem::temp_directory_path() /
+                     "gol_systems_test_big.ckpt")
+                        .string();
+        REQUIRE(save_checkpoint(path, checkpoint));
+        CheckpointFile file;
+        REQUIRE(file.open(path));
+        std::filesystem::remove(path);
+
+        entt::registry dense, sparse;
+        REQUIRE_FALSE(restore_registry(dense, file));
+        REQUIRE(dense.view<Position>().empty());
+        REQUIRE(restore_sparse_registry(sparse, file));
+    }
+
+    TEST_CASE("a restored world carries on as the original would") {
+        entt::registry registry;
+        registry.set<Rule>(highlife_rule);
+        RandGen rand_gen(5);
+        initialise_registry(registry, 400, 40, 30, rand_gen);
+        for (auto round = 0; round < 20; round++) {
+            step_system(registry);
+        }
+
+        CheckpointFile file;
+        checkpoint(registry, file);
+        REQUIRE(file.width() == 40);
+        REQUIRE(file.height() == 30);
+        REQUIRE(file.rule() == highlife_rule);
+        REQUIRE(file.generation() == 20);
+
+        entt::registry dense, sparse;
+        BitGrid grid(file.width(), file.height());
+        Hashlife life(file.rule());
+        REQUIRE(restore_registry(dense, file));
+        REQUIRE(restore_sparse_registry(sparse, file));
+        REQUIRE(restore_grid(grid, file));
+        REQUIRE(restore_hashlife(life, file));
+        dense.set<Rule>(file.rule());
+        sparse.set<Rule>(file.rule());
+        grid.set_rule(file.rule());
+
+        // The universe is unbounded, so it only matches on the first round
+        std::unordered_set<Position> life_alive;
+        life.each_alive(0, 0, 40, 30, [&](std::int64_t x, std::int64_t y) {
+            life_alive.insert(Position(int(x), int(y)));
+        });
+        REQUIRE(life_alive == alive_positions(registry));
+
+        for (auto round = 0; round < 10; round++) {
+            CAPTURE(round);
+            auto expected = alive_positions(registry);
+            REQUIRE(alive_positions(dense) == expected);
+            REQUIRE(alive_positions(sparse) == expected);
+            std::unordered_set<Position> grid_alive;
+            grid.each_alive([&](Position pos) { grid_alive.insert(pos); });
+            REQUIRE(grid_alive == expected);
+
+            step_system(registry);
+            step_system(dense);
+            step_system(sparse);
+            step_system(grid);
+        }
+    }
+
+    TEST_CASE("hashlife keeps the cells outside of the arena") {
+        Hashlife life;
+        life.set(-100, 5, true);
+        life.set(1000, 2000, true);
+        life.set(3, 3, true);
+
+        CheckpointFile file;
+        checkpoint(life, file);
+        Hashlife restored;
+        REQUIRE(restore_hashlife(restored, file));
+        REQUIRE(restored.population() == 3);
+        REQUIRE(restored.get(-100, 5));
+        REQUIRE(restored.get(1000, 2000));
+        REQUIRE(restored.get(3, 3));
+
+        entt::registry registry;
+        REQUIRE(restore_registry(registry, file));
+        REQUIRE(alive_positions(registry) ==
+                std::unordered_set<Position>{Position(3, 3)});
+    }
+}
+
+TEST_SUITE("topologies") {
+    /**
+     * The next generation worked out cell by cell, wrapping each neighbour
+     * on its own.
+     */
+    std::unordered_set<Position>
+    reference_step(const std::unordered_set<Position> &alive,
+                   Topology topology, int width, int height) {
+        std::unordered_set<Position> next;
+        for (auto x = 0; x < width; x++) {
+            for (auto y = 0; y < height; y++) {
+                auto count = 0;
+                Position pos(x, y);
+                for (auto neighbour : find_possible_neighbours(pos)) {
+                    count += alive.count(
+                        wrap_position(topology, neighbour, width, height));
+                }
+                if (conway_rule.next(alive.count(pos), count)) {
+                    next.insert(pos);
+                }
+            }
+        }
+        return next;
+    }
+
+    TEST_CASE("every backend matches stepping cell by cell") {
+        auto topology = Topology::dead;
+        SUBCASE("dead") {}
+        SUBCASE("torus") { topology = Topology::torus; }
+        SUBCASE("Klein bottle") { topology = Topology::klein_bottle; }
+        CAPTURE(topology_name(topology));
+
+        // Wider than a word and with tiles that don't fill the board
+        const int width = 70, height = 67;
+        entt::registry dense, threaded, sparse, systems;
+        for (auto registry : {&dense, &threaded, &sparse, &systems}) {
+            registry->set<Topology>(topology);
+        }
+        RandGen rand_gen_0(21), rand_gen_1(21), rand_gen_2(21);
+        initialise_registry(dense, 1500, width, height, rand_gen_0);
+        initialise_registry(threaded, 1500, width, height, rand_gen_1);
+        initialise_registry(systems, 1500, width, height, rand_gen_2);
+        threaded.set<ThreadPool>(3);
+        BitGrid grid(width, height);
+        grid.set_topology(topology);
+        sparse.set<SparseGrid>(width, height);
+        auto expected = alive_positions(systems);
+        for (auto pos : expected) {
+            auto entity = sparse.create();
+            sparse.assign<Position>(entity, pos);
+            sparse.assign<entt::tag<"is_alive"_hs>>(entity);
+            grid.set(pos.x, pos.y, true);
+        }
+
+        for (auto round = 0; round < 30; round++) {
+            CAPTURE(round);
+            expected = reference_step(expected, topology, width, height);
+            step_system(dense);
+            step_system(threaded);
+            step_system(sparse);
+            lifecycle_system(systems);
+            cleanup_system(systems);
+            update_system(systems);
+            step_system(grid);
+
+            REQUIRE(alive_positions(dense) == expected);
+            REQUIRE(alive_positions(threaded) == expected);
+            REQUIRE(alive_positions(sparse) == expected);
+            REQUIRE(alive_positions(systems) == expected);
+            std::unordered_set<Position> grid_alive;
+            grid.each_alive([&](Position pos) { grid_alive.insert(pos); });
+            REQUIRE(grid_alive == expected);
+        }
+    }
+
+    TEST_CASE("a glider comes back around a torus") {
+        entt::registry registry;
+        registry.set<Topology>(Topology::torus);
+        initialise_registry(registry, 0, 10, 10);
+        std::unordered_set<Position> glider = {
+            Position(1, 0), Position(2, 1), Position(0, 2), Position(1, 2),
+            Position(2, 2)};
+        registry.view<Position>().each([&](auto entity, auto &pos) {
+            if (glider.count(pos)) {
+                registry.assign<entt::tag<"is_alive"_hs>>(entity);
+            }
+        });
+
+        // A glider moves one cell diagonally every four generations
+        for (auto round = 0; round < 40; round++) {
+            step_system(registry);
+            REQUIRE(alive_positions(registry).size() == 5);
+        }
+        REQUIRE(alive_positions(registry) == glider);
+    }
+}
@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(int n_threads) {
+    for (auto worker = 1; worker < std::max(n_threads, 1); worker++) {
+        threads.emplace_back([this, worker] { work(worker); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::run_tasks(int n_tasks, Task task_, void *context_) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = task_;
+        context = context_;
+        task_count = n_tasks;
+        next_task = 0;
+        busy = static_cast<int>(threads.size());
+        generation++;
+    }
+    wake.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busy == 0; });
+}
+
+void ThreadPool::work(int worker) {
+    unsigned long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock,
+                      [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+
+        drain(worker);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::drain(int worker) {
+    for (auto t = next_task++; t < task_count; t = next_task++) {
+        task(context, t, worker);
+    }
+}
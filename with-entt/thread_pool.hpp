@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * A persistent pool of worker threads for splitting a system's work into
+ * tasks.
+ *
+ * The thread calling run takes part in the work, so a pool of one thread runs
+ * everything inline. Tasks are handed out dynamically, and each is told the
+ * index of the worker running it so results can be written to per worker
+ * buffers without locking.
+ */
+class ThreadPool {
+  public:
+    explicit ThreadPool(int n_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Number of threads working on tasks, including the caller.
+     */
+    int size() const { return static_cast<int>(threads.size()) + 1; }
+
+    /**
+     * Call f(task, worker) for each task in [0, n_tasks) and wait for them
+     * all to finish. Worker indices are in [0, size()).
+     */
+    template <typename F> void run(int n_tasks, F &&f) {
+        typedef typename std::remove_reference<F>::type Fn;
+        run_tasks(
+            n_tasks,
+            [](void *fn, int task, int worker) {
+                (*static_cast<Fn *>(fn))(task, worker);
+            },
+            const_cast<void *>(static_cast<const void *>(&f)));
+    }
+
+  private:
+    typedef void (*Task)(void *, int, int);
+
+    void run_tasks(int n_tasks, Task task, void *context);
+    void work(int worker);
+    void drain(int worker);
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    Task task = nullptr;
+    void *context = nullptr;
+    int task_count = 0;
+    std::atomic<int> next_task{0};
+    unsigned long generation = 0;
+    int busy = 0;
+    bool stopping = false;
+};
@@ -0,0 +1,58 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <atomic>
+#include <vector>
+
+#include <doctest.h>
+
+#include "thread_pool.hpp"
+
+TEST_SUITE("ThreadPool") {
+    TEST_CASE("every task is run exactly once") {
+        int n_threads;
+        SUBCASE("1 thread") { n_threads = 1; }
+        SUBCASE("4 threads") { n_threads = 4; }
+
+        ThreadPool pool(n_threads);
+        REQUIRE(pool.size() == n_threads);
+
+        std::vector<std::atomic<int>> runs(1000);
+        pool.run(static_cast<int>(runs.size()),
+                 [&](int task, int worker) { runs[task]++; });
+
+        for (auto &count : runs) {
+            CHECK(count == 1);
+        }
+    }
+
+    TEST_CASE("tasks are told which worker is running them") {
+        ThreadPool pool(3);
+        std::vector<int> per_worker(pool.size(), 0);
+        std::atomic<bool> in_range(true);
+
+        // Each worker only writes its own slot, so no locking is needed
+        pool.run(300, [&](int task, int worker) {
+            if (worker < 0 || worker >= pool.size()) {
+                in_range = false;
+                return;
+            }
+            per_worker[worker]++;
+        });
+
+        REQUIRE(in_range);
+        int total = 0;
+        for (auto count : per_worker) {
+            total += count;
+        }
+        REQUIRE(total == 300);
+    }
+
+    TEST_CASE("the pool can be reused") {
+        ThreadPool pool(4);
+        std::atomic<int> total(0);
+        for (auto round = 0; round < 100; round++) {
+            pool.run(10, [&](int task, int worker) { total += task; });
+        }
+        REQUIRE(total == 100 * 45);
+    }
+}
@@ -0,0 +1,27 @@
+#include <string>
+
+#include "topology.hpp"
+
+bool parse_topology(const std::string &text, Topology &topology) {
+    if (text == "dead") {
+        topology = Topology::dead;
+    } else if (text == "torus") {
+        topology = Topology::torus;
+    } else if (text == "klein") {
+        topology = Topology::klein_bottle;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *topology_name(Topology topology) {
+    switch (topology) {
+    case Topology::torus:
+        return "torus";
+    case Topology::klein_bottle:
+        return "klein";
+    default:
+        return "dead";
+    }
+}
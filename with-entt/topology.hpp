@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+
+#include "components.hpp"
+
+/**
+ * How the edges of the arena meet.
+ *
+ * With a dead border every cell outside of the arena is dead. A torus glues
+ * the left edge to the right and the top to the bottom, so cells leaving one
+ * side come back on the other. A Klein bottle glues left to right the same
+ * way, but glues the top to the bottom mirrored, so cells crossing it come
+ * back flipped left to right.
+ */
+enum class Topology { dead, torus, klein_bottle };
+
+/**
+ * Parse "dead", "torus" or "klein" into topology, returning false for
+ * anything else.
+ */
+bool parse_topology(const std::string &text, Topology &topology);
+
+const char *topology_name(Topology topology);
+
+/**
+ * The cell of a width x height arena at the origin that a position up to one
+ * arena outside of it stands for. Positions inside the arena, and any
+ * position with a dead border, are their own cell.
+ */
+inline Position wrap_position(Topology topology, Position pos, int width,
+                              int height) {
+    if (topology == Topology::dead) {
+        return pos;
+    }
+    if (pos.y < 0 || pos.y >= height) {
+        pos.y += pos.y < 0 ? height : -height;
+        if (topology == Topology::klein_bottle) {
+            pos.x = width - 1 - pos.x;
+        }
+    }
+    if (pos.x < 0) {
+        pos.x += width;
+    } else if (pos.x >= width) {
+        pos.x -= width;
+    }
+    return pos;
+}
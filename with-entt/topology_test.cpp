@@ -0,0 +1,71 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+
+#include <string>
+
+#include <doctest.h>
+
+#include "components.hpp"
+#include "topology.hpp"
+
+TEST_SUITE("parse_topology") {
+    TEST_CASE("every topology parses back from its name") {
+        for (auto topology :
+             {Topology::dead, Topology::torus, Topology::klein_bottle}) {
+            Topology parsed = Topology::dead;
+            REQUIRE(parse_topology(topology_name(topology), parsed));
+            REQUIRE(parsed == topology);
+        }
+    }
+
+    TEST_CASE("anything else is rejected") {
+        Topology topology = Topology::torus;
+        REQUIRE_FALSE(parse_topology("", topology));
+        REQUIRE_FALSE(parse_topology("sphere", topology));
+        REQUIRE(topology == Topology::torus);
+    }
+}
+
+TEST_SUITE("wrap_position") {
+    TEST_CASE("positions inside the arena are their own cell") {
+        for (auto topology :
+             {Topology::dead, Topology::torus, Topology::klein_bottle}) {
+            REQUIRE(wrap_position(topology, Position(0, 0), 10, 5) ==
+                    Position(0, 0));
+            REQUIRE(wrap_position(topology, Position(9, 4), 10, 5) ==
+                    Position(9, 4));
+        }
+    }
+
+    TEST_CASE("a dead border leaves positions outside the arena alone") {
+        REQUIRE(wrap_position(Topology::dead, Position(-1, 5), 10, 5) ==
+                Position(-1, 5));
+    }
+
+    TEST_CASE("a torus joins opposite edges") {
+        auto torus = Topology::torus;
+        REQUIRE(wrap_position(torus, Position(-1, 2), 10, 5) ==
+                Position(9, 2));
+        REQUIRE(wrap_position(torus, Position(10, 2), 10, 5) ==
+                Position(0, 2));
+        REQUIRE(wrap_position(torus, Position(3, -1), 10, 5) ==
+                Position(3, 4));
+        REQUIRE(wrap_position(torus, Position(3, 5), 10, 5) ==
+                Position(3, 0));
+        REQUIRE(wrap_position(torus, Position(-1, -1), 10, 5) ==
+                Position(9, 4));
+    }
+
+    TEST_CASE("a Klein bottle flips positions across the top and bottom") {
+        auto klein = Topology::klein_bottle;
+        REQUIRE(wrap_position(klein, Position(-1, 2), 10, 5) ==
+                Position(9, 2));
+        REQUIRE(wrap_position(klein, Position(3, -1), 10, 5) ==
+                Position(6, 4));
+        REQUIRE(wrap_position(klein, Position(3, 5), 10, 5) ==
+                Position(6, 0));
+        REQUIRE(wrap_position(klein, Position(-1, -1), 10, 5) ==
+                Position(0, 4));
+        REQUIRE(wrap_position(klein, Position(10, 5), 10, 5) ==
+                Position(9, 0));
+    }
+}
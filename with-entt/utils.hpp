@@ -1,20 +1,47 @@
 #pragma once
 
+#include <array>
+#include <iterator>
 #include <random>
 
-#include <entt/entt.hpp>
-
 #include "components.hpp"
+#include "random.hpp"
 
-bool has_alive_cells(entt::registry &registry);
 bool is_neighbour(Position from, Position to);
-std::vector<Position> find_possible_neighbours(Position pos);
 
-template <typename Iter>
-Iter rand_choice(Iter start, Iter end) {
-    std::random_device rand_dev;
-    std::mt19937 rand_gen(rand_dev());
+/**
+ * Offsets from a position to each of its eight neighbours.
+ */
+constexpr std::array<Position, 8> neighbour_offsets = {{
+    {-1, 1}, {0, 1}, {1, 1},
+    {-1, 0}, {1, 0},
+    {-1, -1}, {0, -1}, {1, -1},
+}};
+
+/**
+ * The positions of the eight cells surrounding the given position.
+ */
+constexpr std::array<Position, 8> find_possible_neighbours(Position pos) {
+    std::array<Position, 8> neighbours = neighbour_offsets;
+    for (auto &neighbour : neighbours) {
+        neighbour.x += pos.x;
+        neighbour.y += pos.y;
+    }
+    return neighbours;
+}
+
+template <typename Iter, typename Gen>
+Iter rand_choice(Iter start, Iter end, Gen &rand_gen) {
     std::uniform_int_distribution<> dist(0, std::distance(start, end) - 1);
     std::advance(start, dist(rand_gen));
     return start;
 }
+
+/**
+ * Random choice from a generator seeded once per thread.
+ */
+template <typename Iter>
+Iter rand_choice(Iter start, Iter end) {
+    thread_local RandGen rand_gen(random_seed());
+    return rand_choice(start, end, rand_gen);
+}
@@ -0,0 +1,65 @@
+#include <cstdint>
+#include <random>
+
+#include <benchmark/benchmark.h>
+#include <entt/entt.hpp>
+
+#include "backends.hpp"
+#include "bench.hpp"
+#include "bitgrid.hpp"
+#include "components.hpp"
+#include "utils.hpp"
+
+// Every cell asks for its neighbours in the lifecycle, so this is the floor
+// on the cost of a neighbour lookup.
+static void BM_find_possible_neighbours(benchmark::State &state) {
+    auto dim = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        std::int64_t sum = 0;
+        for (auto x = 0; x < dim; x++) {
+            for (auto y = 0; y < dim; y++) {
+                auto neighbours = find_possible_neighbours(Position(x, y));
+                for (auto neighbour : neighbours) {
+                    sum += neighbour.x ^ neighbour.y;
+                }
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * dim * dim);
+}
+BENCHMARK(BM_find_possible_neighbours)
+    ->Arg(64)
+    ->Arg(256)
+    ->Arg(1024)
+    ->Unit(benchmark::kMicrosecond);
+
+// Checked after every round of the main loop. Boards that have died out are
+// when the check matters.
+static void BM_has_alive_cells(benchmark::State &state) {
+    auto dim = static_cast<int>(state.range(0));
+    entt::registry registry;
+    seed_board(registry, dim, state.range(1) / 100.0);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(has_alive_cells(registry));
+    }
+}
+BENCHMARK(BM_has_alive_cells)->Apply(size_density_matrix);
+
+static void BM_has_alive_cells_bitgrid(benchmark::State &state) {
+    auto dim = static_cast<int>(state.range(0));
+    BitGrid grid(dim, dim);
+    std::mt19937 rand_gen(42);
+    std::bernoulli_distribution alive(state.range(1) / 100.0);
+    for (auto x = 0; x < dim; x++) {
+        for (auto y = 0; y < dim; y++) {
+            grid.set(x, y, alive(rand_gen));
+        }
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(has_alive_cells(grid));
+    }
+}
+BENCHMARK(BM_has_alive_cells_bitgrid)->Apply(size_density_matrix);
@@ -3,6 +3,7 @@
 #include <rapidcheck.h>
 #include <rapidcheck/gtest.h>
 
+#include "backends.hpp"
 #include "components.hpp"
 #include "utils.hpp"
 
@@ -49,6 +50,21 @@ RC_GTEST_PROP(find_possible_neighbours, all_pass_is_neighbour,
         [pos](const auto other) { return is_neighbour(pos, other); }));
 }
 
+RC_GTEST_PROP(find_possible_neighbours, matches_neighbour_offsets,
+              (const Position &pos)) {
+    const auto neighbours = find_possible_neighbours(pos);
+    for (std::size_t i = 0; i < neighbours.size(); i++) {
+        RC_ASSERT(neighbours[i] == Position(pos.x + neighbour_offsets[i].x,
+                                            pos.y + neighbour_offsets[i].y));
+    }
+}
+
+// Neighbours are fixed size and can be found at compile time
+static_assert(find_possible_neighbours(Position(5, 5)).size() == 8, "");
+static_assert(find_possible_neighbours(Position(5, 5))[0].x == 4 &&
+                  find_possible_neighbours(Position(5, 5))[0].y == 6,
+              "");
+
 RC_GTEST_PROP(has_alive_cells, has_some_alive_cells, ()) {
     entt::registry registry;
     auto alive_positions = *rc::gen::nonEmpty<std::unordered_set<Position>>();